@@ -1,5 +1,6 @@
 #include "platform.hpp"
 #include <string>
+#include <cstdlib>
 #include <cmath>
 #include <climits>
 #include <limits>
@@ -14,6 +15,7 @@
 	#define PLATFORM_LINUX
 	#include <libgen.h>
 	#include <unistd.h>
+	#include <sys/stat.h>
 #elif defined( __HAIKU__ ) || defined( __BEOS__ )
 	#define PLATFORM_HAIKU
 	#include <kernel/OS.h>
@@ -98,3 +100,23 @@ std::string ResourcePath(std::string fileName) {
 	return GetProcessPath() + "/resources/" + fileName;
 }
 
+// follows the XDG base directory spec: $XDG_CACHE_HOME, or ~/.cache if that isn't set
+std::string CachePath(std::string fileName) {
+	std::string dir;
+	const char* xdgCacheHome = getenv("XDG_CACHE_HOME");
+	const char* home = getenv("HOME");
+	if (xdgCacheHome && xdgCacheHome[0]) {
+		dir = xdgCacheHome;
+		mkdir(dir.c_str(), 0755);
+	} else if (home && home[0]) {
+		dir = std::string(home) + "/.cache";
+		mkdir(dir.c_str(), 0755);
+	} else {
+		return GetProcessPath() + "/" + fileName;
+	}
+
+	dir += "/opengl-series";
+	mkdir(dir.c_str(), 0755); // fails harmlessly if it already exists
+	return dir + "/" + fileName;
+}
+
@@ -13,7 +13,7 @@ function create_project( name )
 			links {"glu32", "opengl32", "gdi32", "winmm", "user32","GLEW"}
 
 		configuration "linux"
-			links {"GL","glfw","GLEW"}
+			links {"GL","glfw","GLEW","pthread"}
 		
 		configuration "macosx"
 			links {"GL","glfw","GLEW", "CoreFoundation.framework"}
@@ -53,3 +53,33 @@ solution "opengl-series"
 	create_project( "06_diffuse_lighting" );
 	create_project( "07_more_lighting" );
 	create_project( "08_even_more_lighting" );
+
+	-- CPU benchmarks for tdogl::Bitmap. Doesn't use OpenGL, so it runs headless.
+	project "bitmap_benchmark"
+		kind "ConsoleApp"
+		language "C++"
+		files {
+			"../../source/bitmap_benchmark/source/**.cpp",
+			"../../source/08_even_more_lighting/source/tdogl/Bitmap.cpp",
+			"../../source/08_even_more_lighting/source/tdogl/BitmapResample.cpp",
+			"../../source/08_even_more_lighting/source/tdogl/Parallel.cpp",
+			"../../source/08_even_more_lighting/source/tdogl/PixelAllocator.cpp"
+		}
+		targetdir("../../source/bitmap_benchmark/")
+		includedirs( "../../source/08_even_more_lighting/source/" )
+		includedirs( "../../source/common/thirdparty/stb_image" )
+		
+		configuration "linux"
+			links {"pthread"}
+		
+		configuration "debug"
+			defines { "DEBUG" }
+			flags { "Symbols" }
+			buildoptions{ "-Wall" }
+			targetname ( "bitmap_benchmark-debug" )
+
+		configuration "release"
+			defines { "NDEBUG" }
+			flags { "Optimize" }
+			buildoptions{ "-Wall" }
+			targetname ( "bitmap_benchmark-release" )
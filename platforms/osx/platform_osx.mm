@@ -13,3 +13,19 @@ std::string ResourcePath(std::string fileName) {
     NSString* path = [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:fname];
     return std::string([path cStringUsingEncoding:NSUTF8StringEncoding]);
 }
+
+// returns the full path to the file `fileName` in ~/Library/Caches/<bundle identifier>
+std::string CachePath(std::string fileName) {
+    NSString* appName = [[NSBundle mainBundle] bundleIdentifier];
+    if(!appName)
+        appName = [[NSProcessInfo processInfo] processName];
+    
+    NSArray* cacheDirs = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+    NSString* dir = ([cacheDirs count] > 0) ? [cacheDirs objectAtIndex:0] : NSTemporaryDirectory();
+    dir = [dir stringByAppendingPathComponent:appName];
+    [[NSFileManager defaultManager] createDirectoryAtPath:dir withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    NSString* fname = [NSString stringWithCString:fileName.c_str() encoding:NSUTF8StringEncoding];
+    NSString* path = [dir stringByAppendingPathComponent:fname];
+    return std::string([path cStringUsingEncoding:NSUTF8StringEncoding]);
+}
@@ -1,5 +1,6 @@
 #include "platform.hpp"
 #include <windows.h>
+#include <cstdlib>
 
 std::string ResourcePath(std::string fileName) {
     char executablePath[1024] = {'\0'};
@@ -10,3 +11,12 @@ std::string ResourcePath(std::string fileName) {
         throw std::runtime_error("GetModuleFileName failed a bit");
 }
 
+std::string CachePath(std::string fileName) {
+    const char* localAppData = getenv("LOCALAPPDATA");
+    if(!localAppData || !localAppData[0])
+        return ResourcePath(fileName);
+
+    std::string dir = std::string(localAppData) + "\\opengl-series";
+    CreateDirectoryA(dir.c_str(), NULL); // fails harmlessly if it already exists
+    return dir + "\\" + fileName;
+}
@@ -25,16 +25,23 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 // standard C++ libraries
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
 #include <cmath>
+#include <cstddef>
 #include <list>
-#include <sstream>
 
 // tdogl classes
 #include "tdogl/Program.h"
 #include "tdogl/Texture.h"
+#include "tdogl/ProgramCache.h"
+#include "tdogl/TextureCache.h"
+#include "tdogl/SamplerCache.h"
+#include "tdogl/TextureResidency.h"
+#include "tdogl/TextureStreamer.h"
+#include "tdogl/UniformBuffer.h"
 #include "tdogl/Camera.h"
 
 /*
@@ -89,6 +96,9 @@ struct ModelInstance {
 
 /*
  Represents a point light
+
+ The layout matches the std140 layout of the `Light` struct in the fragment shader,
+ so an array of these can be copied straight into the `Lights` uniform block.
  */
 struct Light {
     glm::vec4 position;
@@ -96,11 +106,36 @@ struct Light {
     float attenuation;
     float ambientCoefficient;
     float coneAngle;
+    float padding1[2]; //std140 puts vec3s on a 16 byte boundary
     glm::vec3 coneDirection;
+    float padding2; //std140 rounds the size of structs up to a multiple of 16 bytes
 };
+static_assert(sizeof(Light) == 64 && offsetof(Light, coneDirection) == 48, "Light must match the std140 layout");
 
 // constants
 const glm::vec2 SCREEN_SIZE(800, 600);
+const size_t MAX_LIGHTS = 10; // must match MAX_LIGHTS in the fragment shader
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHTS_BLOCK_BINDING = 1;
+
+/*
+ The `Camera` uniform block, in std140 layout
+ */
+struct CameraBlock {
+    glm::mat4 camera;
+    glm::vec3 cameraPosition;
+    float padding;
+};
+
+/*
+ The `Lights` uniform block, in std140 layout
+ */
+struct LightsBlock {
+    GLint numLights;
+    GLint padding[3]; //std140 puts arrays of structs on a 16 byte boundary
+    Light allLights[MAX_LIGHTS];
+};
+static_assert(offsetof(LightsBlock, allLights) == 16, "LightsBlock must match the std140 layout");
 
 // globals
 GLFWwindow* gWindow = NULL;
@@ -110,22 +145,30 @@ ModelAsset gWoodenCrate;
 std::list<ModelInstance> gInstances;
 GLfloat gDegreesRotated = 0.0f;
 std::vector<Light> gLights;
+tdogl::TextureResidency gTextureResidency(256 * 1024 * 1024);
+tdogl::TextureStreamer gTextureStreamer;
+tdogl::UniformBuffer* gCameraUniforms = NULL;
+tdogl::UniformBuffer* gLightsUniforms = NULL;
 
 
-// returns a new tdogl::Program created from the given vertex and fragment shader filenames
+// returns a new tdogl::Program created from the given vertex and fragment shader filenames.
+// the linked program is cached on disk, so later runs skip compiling the shaders.
 static tdogl::Program* LoadShaders(const char* vertFilename, const char* fragFilename) {
-    std::vector<tdogl::Shader> shaders;
-    shaders.push_back(tdogl::Shader::shaderFromFile(ResourcePath(vertFilename), GL_VERTEX_SHADER));
-    shaders.push_back(tdogl::Shader::shaderFromFile(ResourcePath(fragFilename), GL_FRAGMENT_SHADER));
-    return new tdogl::Program(shaders);
+    tdogl::ProgramCache cache(CachePath("program-cache"));
+    return cache.load(ResourcePath(vertFilename), ResourcePath(fragFilename)).release();
 }
 
 
 // returns a new tdogl::Texture created from the given filename
 static tdogl::Texture* LoadTexture(const char* filename) {
-    tdogl::Bitmap bmp = tdogl::Bitmap::bitmapFromFile(ResourcePath(filename));
-    bmp.flipVertically();
-    return new tdogl::Texture(bmp);
+    // decoded, flipped and mipmapped textures are cached, so this only decodes the image the first time
+    tdogl::TextureCache cache(CachePath("texture-cache"));
+    std::unique_ptr<tdogl::TextureFile> file = cache.load(ResourcePath(filename));
+    // starts out blurry and sharpens over the next few frames, instead of uploading every level now
+    tdogl::Texture* texture = gTextureStreamer.stream(*file);
+    // the residency manager keeps the file mapped, for the streamer and for restoring the texture if it gets shrunk
+    gTextureResidency.add(texture, std::move(file));
+    return texture;
 }
 
 
@@ -258,15 +301,6 @@ static void CreateInstances() {
     gInstances.push_back(hMid);
 }
 
-template <typename T>
-void SetLightUniform(tdogl::Program* shaders, const char* propertyName, size_t lightIndex, const T& value) {
-    std::ostringstream ss;
-    ss << "allLights[" << lightIndex << "]." << propertyName;
-    std::string uniformName = ss.str();
-
-    shaders->setUniform(uniformName.c_str(), value);
-}
-
 //renders a single `ModelInstance`
 static void RenderInstance(const ModelInstance& inst) {
     ModelAsset* asset = inst.asset;
@@ -275,27 +309,20 @@ static void RenderInstance(const ModelInstance& inst) {
     //bind the shaders
     shaders->use();
 
-    //set the shader uniforms
-    shaders->setUniform("camera", gCamera.matrix());
-    shaders->setUniform("model", inst.transform);
-    shaders->setUniform("materialTex", 0); //set to 0 because the texture will be bound to GL_TEXTURE0
-    shaders->setUniform("materialShininess", asset->shininess);
-    shaders->setUniform("materialSpecularColor", asset->specularColor);
-    shaders->setUniform("cameraPosition", gCamera.position());
-    shaders->setUniform("numLights", (int)gLights.size());
-
-    for(size_t i = 0; i < gLights.size(); ++i){
-        SetLightUniform(shaders, "position", i, gLights[i].position);
-        SetLightUniform(shaders, "intensities", i, gLights[i].intensities);
-        SetLightUniform(shaders, "attenuation", i, gLights[i].attenuation);
-        SetLightUniform(shaders, "ambientCoefficient", i, gLights[i].ambientCoefficient);
-        SetLightUniform(shaders, "coneAngle", i, gLights[i].coneAngle);
-        SetLightUniform(shaders, "coneDirection", i, gLights[i].coneDirection);
-    }
+    //set the shader uniforms. The names are hashed at compile time
+    using namespace tdogl::literals;
+    shaders->setUniform("model"_uniform, inst.transform);
+    shaders->setUniform("materialTex"_uniform, 0); //set to 0 because the texture will be bound to GL_TEXTURE0
+    shaders->setUniform("materialShininess"_uniform, asset->shininess);
+    shaders->setUniform("materialSpecularColor"_uniform, asset->specularColor);
+    //the camera and lights come from uniform buffers, see UpdateFrameUniforms
 
-    //bind the texture
+    //bind the texture, restoring it first if it was shrunk to fit the VRAM budget
+    gTextureResidency.use(asset->texture);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, asset->texture->object());
+    if(tdogl::SamplerCache::isSupported())
+        glBindSampler(0, asset->texture->sampler(8.0f));
 
     //bind VAO and draw
     glBindVertexArray(asset->vao);
@@ -304,16 +331,41 @@ static void RenderInstance(const ModelInstance& inst) {
     //unbind everything
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
+    if(tdogl::SamplerCache::isSupported())
+        glBindSampler(0, 0);
     shaders->stopUsing();
 }
 
 
+// uploads the uniforms that are the same for every instance, once per frame
+static void UpdateFrameUniforms() {
+    CameraBlock camera = CameraBlock();
+    camera.camera = gCamera.matrix();
+    camera.cameraPosition = gCamera.position();
+    gCameraUniforms->update(camera);
+
+    if(gLights.size() > MAX_LIGHTS)
+        throw std::runtime_error("Too many lights");
+    LightsBlock lights = LightsBlock();
+    lights.numLights = (GLint)gLights.size();
+    std::copy(gLights.begin(), gLights.end(), lights.allLights);
+    // only upload the lights that are used
+    gLightsUniforms->update(&lights, offsetof(LightsBlock, allLights) + gLights.size() * sizeof(Light));
+}
+
+
 // draws a single frame
 static void Render() {
     // clear everything
     glClearColor(0, 0, 0, 1); // black
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // upload more of the streaming textures, then shrink textures that haven't been drawn recently if they're over budget
+    gTextureStreamer.beginFrame();
+    gTextureResidency.beginFrame();
+
+    UpdateFrameUniforms();
+
     // render all the instances
     std::list<ModelInstance>::const_iterator it;
     for(it = gInstances.begin(); it != gInstances.end(); ++it){
@@ -438,6 +490,12 @@ void AppMain() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // every program reads the camera and lights from the same uniform buffers
+    tdogl::Program::setUniformBlockBinding("Camera", CAMERA_BLOCK_BINDING);
+    tdogl::Program::setUniformBlockBinding("Lights", LIGHTS_BLOCK_BINDING);
+    gCameraUniforms = new tdogl::UniformBuffer(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+    gLightsUniforms = new tdogl::UniformBuffer(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+
     // initialise the gWoodenCrate asset
     LoadWoodenCrateAsset();
 
@@ -449,8 +507,8 @@ void AppMain() {
     gCamera.setViewportAspectRatio(SCREEN_SIZE.x / SCREEN_SIZE.y);
     gCamera.setNearAndFarPlanes(0.5f, 100.0f);
 
-    // setup lights
-    Light spotlight;
+    // setup lights, zeroing the fields they leave unset, like the std140 padding
+    Light spotlight = Light();
     spotlight.position = glm::vec4(-4,0,10,1);
     spotlight.intensities = glm::vec3(2,2,2); //strong white light
     spotlight.attenuation = 0.1f;
@@ -458,7 +516,7 @@ void AppMain() {
     spotlight.coneAngle = 15.0f;
     spotlight.coneDirection = glm::vec3(0,0,-1);
 
-    Light directionalLight;
+    Light directionalLight = Light();
     directionalLight.position = glm::vec4(1, 0.8, 0.6, 0); //w == 0 indications a directional light
     directionalLight.intensities = glm::vec3(0.4,0.3,0.1); //weak yellowish light
     directionalLight.ambientCoefficient = 0.06f;
@@ -492,6 +550,9 @@ void AppMain() {
     }
 
     // clean up and exit
+    tdogl::SamplerCache::clear();
+    delete gCameraUniforms;
+    delete gLightsUniforms;
     glfwTerminate();
 }
 
@@ -0,0 +1,144 @@
+/*
+ tdogl::AsyncProgram
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "AsyncProgram.h"
+#include <stdexcept>
+#include <cstring>
+
+//the bundled GLEW predates GL_KHR_parallel_shader_compile. The ARB version uses the same value.
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+using namespace tdogl;
+
+// -1 until the extensions have been checked
+static int gParallelSupported = -1;
+
+static std::string ShaderInfoLog(GLuint shader) {
+    GLint infoLogLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogLength);
+    std::vector<char> log(infoLogLength + 1, '\0');
+    glGetShaderInfoLog(shader, infoLogLength, NULL, &log[0]);
+    return std::string(&log[0]);
+}
+
+AsyncProgram::AsyncProgram(const std::vector<ProgramCache::ShaderSource>& sources) :
+    _object(0)
+{
+    if(sources.size() <= 0)
+        throw std::runtime_error("No shaders were provided to create the program");
+
+    try {
+        //submit every compile before asking about any of them
+        for(size_t i = 0; i < sources.size(); ++i){
+            GLuint shader = glCreateShader(sources[i].type);
+            if(shader == 0)
+                throw std::runtime_error("glCreateShader failed");
+            _shaders.push_back(shader);
+
+            const char* code = sources[i].code.c_str();
+            glShaderSource(shader, 1, (const GLchar**)&code, NULL);
+            glCompileShader(shader);
+        }
+
+        _object = glCreateProgram();
+        if(_object == 0)
+            throw std::runtime_error("glCreateProgram failed");
+
+        if(Program::binariesSupported())
+            glProgramParameteri(_object, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        //linking waits for the compiles inside the driver, not on this thread
+        for(size_t i = 0; i < _shaders.size(); ++i)
+            glAttachShader(_object, _shaders[i]);
+        glLinkProgram(_object);
+    } catch(...) {
+        _deleteShaders();
+        if(_object != 0) glDeleteProgram(_object);
+        throw;
+    }
+}
+
+AsyncProgram::~AsyncProgram() {
+    _deleteShaders();
+    //0 if get was called
+    if(_object != 0) glDeleteProgram(_object);
+}
+
+bool AsyncProgram::isReady() const {
+    if(_object == 0 || !isParallelSupported())
+        return true;
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(_object, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+std::unique_ptr<Program> AsyncProgram::get() {
+    if(_object == 0)
+        throw std::runtime_error("AsyncProgram::get was already called");
+
+    //this is the first status check, so it's where the driver makes us wait
+    GLint linked = GL_FALSE;
+    glGetProgramiv(_object, GL_LINK_STATUS, &linked);
+    if(linked == GL_FALSE){
+        //a compile failure explains more than the link failure that follows it
+        for(size_t i = 0; i < _shaders.size(); ++i){
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(_shaders[i], GL_COMPILE_STATUS, &compiled);
+            if(compiled == GL_FALSE)
+                throw std::runtime_error("Compile failure in shader:\n" + ShaderInfoLog(_shaders[i]));
+        }
+    }
+
+    _deleteShaders();
+    std::unique_ptr<Program> program(new Program());
+    program->_object = _object;
+    _object = 0;
+
+    program->_checkLinkStatus();
+    program->_linked();
+    return program;
+}
+
+bool AsyncProgram::isParallelSupported() {
+    if(gParallelSupported < 0){
+        gParallelSupported = 0;
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for(GLint i = 0; i < extensionCount; ++i){
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if(name && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+                        strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+            {
+                gParallelSupported = 1;
+                break;
+            }
+        }
+    }
+    return gParallelSupported == 1;
+}
+
+void AsyncProgram::_deleteShaders() {
+    for(size_t i = 0; i < _shaders.size(); ++i){
+        if(_object != 0) glDetachShader(_object, _shaders[i]);
+        glDeleteShader(_shaders[i]);
+    }
+    _shaders.clear();
+}
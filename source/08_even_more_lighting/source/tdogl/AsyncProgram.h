@@ -0,0 +1,105 @@
+/*
+ tdogl::AsyncProgram
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <GL/glew.h>
+#include "Program.h"
+#include "ProgramCache.h"
+#include <memory>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A program that is still being compiled and linked, like a std::future for a
+     tdogl::Program.
+
+     tdogl::Shader and tdogl::Program check the compile and link status as soon as
+     they are made, which makes the driver finish compiling before anything else
+     can be submitted. This class submits every shader and the link straight away,
+     and only checks the status when `get` is called. Making all the programs
+     first and calling `get` afterwards lets the driver compile them at the same
+     time, on its own threads when it supports GL_KHR_parallel_shader_compile.
+
+     Example:
+
+         std::vector<tdogl::AsyncProgram*> pending;
+         for(size_t i = 0; i < variants.size(); ++i)
+             pending.push_back(new tdogl::AsyncProgram(variants[i]));
+
+         //later, e.g. once per frame until they're all done
+         if(pending[i]->isReady())
+             programs[i] = pending[i]->get().release();
+
+     Like all OpenGL calls, everything here must happen on the thread that owns the
+     OpenGL context.
+     */
+    class AsyncProgram {
+    public:
+        /**
+         Submits the shaders to be compiled and the program to be linked, without
+         waiting for either to finish.
+
+         @param sources  The source code and type of each shader in the program
+         @throws std::exception if no shaders are given, or an object can't be created
+         */
+        explicit AsyncProgram(const std::vector<ProgramCache::ShaderSource>& sources);
+
+        /**
+         Deletes the shaders, and the program if `get` wasn't called
+         */
+        ~AsyncProgram();
+
+        /**
+         @result true if `get` won't have to wait for the driver. This checks
+                 GL_COMPLETION_STATUS_KHR, so it never blocks. Without
+                 GL_KHR_parallel_shader_compile it is always true, and `get` may
+                 wait for the compile to finish.
+         */
+        bool isReady() const;
+
+        /**
+         Waits for the compile and link to finish if necessary, then checks them.
+         Can only be called once.
+
+         @result The linked program. The caller owns it.
+         @throws std::exception if a shader failed to compile, the program failed to
+                 link, or `get` was already called
+         */
+        std::unique_ptr<Program> get();
+
+        /**
+         @result true if the context supports GL_KHR_parallel_shader_compile (or the
+                 ARB version), so shaders are compiled on background driver threads
+                 and `isReady` is meaningful
+         */
+        static bool isParallelSupported();
+
+    private:
+        GLuint _object;
+        std::vector<GLuint> _shaders;
+
+        void _deleteShaders();
+
+        //copying disabled
+        AsyncProgram(const AsyncProgram&);
+        const AsyncProgram& operator=(const AsyncProgram&);
+    };
+
+}
@@ -17,88 +17,431 @@
  */
 
 #include "Bitmap.h"
+#include "Parallel.h"
+#include "PixelAllocator.h"
 #include <stdexcept>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 
 //uses stb_image to try load files
 #define STBI_FAILURE_USERMSG
+//bitmapsFromFiles decodes on many threads, so each thread needs its own failure reason
+#define STBI_THREAD_LOCAL thread_local
+//stb_image allocates through the pixel allocator, so the decoder's scratch buffers are pooled
+//and the decoded pixels can be adopted by a bitmap
+#define STBI_MALLOC(sz) tdogl::PixelAllocator::current().allocate(sz)
+#define STBI_REALLOC(p, sz) tdogl::PixelAllocator::current().reallocate(p, sz)
+#define STBI_FREE(p) tdogl::PixelAllocator::current().deallocate(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+//vector instruction sets available to the row converters, decided at compile time
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TDOGL_BITMAP_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define TDOGL_BITMAP_NEON
+    #include <arm_neon.h>
+#endif
+
 using namespace tdogl;
 
 
-inline unsigned char AverageRGB(unsigned char rgb[3]) {
-    return (unsigned char)(((double)rgb[0] + (double)rgb[1] + (double)rgb[2]) / 3.0);
+/*
+ * Row converters
+ *
+ * Each converter converts `count` consecutive pixels from one format to another.
+ * The vector loops handle as many whole blocks of pixels as they can, and the
+ * scalar loop at the end of each function handles whatever is left over.
+ */
+
+// floor((r + g + b) / 3) without a division. Exact for all sums up to 765.
+inline unsigned char AverageRGB(const unsigned char* rgb) {
+    return (unsigned char)((((unsigned)rgb[0] + rgb[1] + rgb[2]) * 0xAAABu) >> 17);
 }
 
-static void Grayscale2GrayscaleAlpha(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = 255;
+#if defined(TDOGL_BITMAP_SSE2)
+// sums of up to 765 in 16 bit lanes -> averages in 16 bit lanes
+static inline __m128i SSE2Divide3(__m128i sums) {
+    return _mm_srli_epi16(_mm_mulhi_epu16(sums, _mm_set1_epi16((short)0xAAAB)), 1);
 }
 
-static void Grayscale2RGB(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[0];
-    dest[2] = src[0];
+// four RGBA pixels -> four (r + g + b) sums in 32 bit lanes
+static inline __m128i SSE2SumRGB(__m128i rgba) {
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(rgba, lowByte);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(rgba, 8), lowByte);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(rgba, 16), lowByte);
+    return _mm_add_epi32(_mm_add_epi32(r, g), b);
 }
 
-static void Grayscale2RGBA(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[0];
-    dest[2] = src[0];
-    dest[3] = 255;
+// four RGB pixels in the low 12 bytes -> four pixels in 32 bit lanes, with a zero fourth byte
+static inline __m128i SSE2ExpandRGB(__m128i rgb) {
+    const __m128i lowPixel = _mm_set1_epi64x(0xFFFFFF);
+    //two pixels in the low 6 bytes of each 64 bit lane
+    __m128i pairs = _mm_unpacklo_epi64(rgb, _mm_srli_si128(rgb, 6));
+    __m128i hiPixel = _mm_and_si128(_mm_slli_epi64(pairs, 8), _mm_set1_epi64x(0xFFFFFF00000000LL));
+    return _mm_or_si128(_mm_and_si128(pairs, lowPixel), hiPixel);
 }
 
-static void GrayscaleAlpha2Grayscale(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
+// four pixels in 32 bit lanes -> four RGB pixels in the low 12 bytes, with zeros above them
+static inline __m128i SSE2PackRGB(__m128i rgba) {
+    const __m128i lowPixel = _mm_set1_epi64x(0xFFFFFF);
+    __m128i hiPixel = _mm_and_si128(_mm_srli_epi64(rgba, 8), _mm_set1_epi64x(0xFFFFFF000000LL));
+    //two pixels in the low 6 bytes of each 64 bit lane
+    __m128i pairs = _mm_or_si128(_mm_and_si128(rgba, lowPixel), hiPixel);
+    return _mm_or_si128(_mm_move_epi64(pairs), _mm_slli_si128(_mm_srli_si128(pairs, 8), 6));
 }
 
-static void GrayscaleAlpha2RGB(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[0];
-    dest[2] = src[0];
+// 48 bytes of RGB -> sixteen pixels in the 32 bit lanes of `pixels`
+static inline void SSE2LoadRGB(const unsigned char* src, __m128i pixels[4]) {
+    __m128i in0 = _mm_loadu_si128((const __m128i*)(src));
+    __m128i in1 = _mm_loadu_si128((const __m128i*)(src + 16));
+    __m128i in2 = _mm_loadu_si128((const __m128i*)(src + 32));
+    pixels[0] = SSE2ExpandRGB(in0);
+    pixels[1] = SSE2ExpandRGB(_mm_or_si128(_mm_srli_si128(in0, 12), _mm_slli_si128(in1, 4)));
+    pixels[2] = SSE2ExpandRGB(_mm_or_si128(_mm_srli_si128(in1, 8), _mm_slli_si128(in2, 8)));
+    pixels[3] = SSE2ExpandRGB(_mm_srli_si128(in2, 4));
 }
 
-static void GrayscaleAlpha2RGBA(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[0];
-    dest[2] = src[0];
-    dest[3] = src[1];
+// sixteen pixels in the 32 bit lanes of `pixels` -> 48 bytes of RGB. The fourth bytes are ignored.
+static inline void SSE2StoreRGB(const __m128i pixels[4], unsigned char* dest) {
+    __m128i a0 = SSE2PackRGB(pixels[0]);
+    __m128i a1 = SSE2PackRGB(pixels[1]);
+    __m128i a2 = SSE2PackRGB(pixels[2]);
+    __m128i a3 = SSE2PackRGB(pixels[3]);
+    _mm_storeu_si128((__m128i*)(dest), _mm_or_si128(a0, _mm_slli_si128(a1, 12)));
+    _mm_storeu_si128((__m128i*)(dest + 16), _mm_or_si128(_mm_srli_si128(a1, 4), _mm_slli_si128(a2, 8)));
+    _mm_storeu_si128((__m128i*)(dest + 32), _mm_or_si128(_mm_srli_si128(a2, 8), _mm_slli_si128(a3, 4)));
 }
 
-static void RGB2Grayscale(unsigned char* src, unsigned char* dest){
-    dest[0] = AverageRGB(src);
+// 16 gray bytes -> 48 bytes of RGB
+static inline void SSE2StoreGrayAsRGB(__m128i gray, unsigned char* dest) {
+    __m128i gg = _mm_unpacklo_epi8(gray, gray);
+    __m128i pixels[4];
+    pixels[0] = _mm_unpacklo_epi16(gg, gg);
+    pixels[1] = _mm_unpackhi_epi16(gg, gg);
+    gg = _mm_unpackhi_epi8(gray, gray);
+    pixels[2] = _mm_unpacklo_epi16(gg, gg);
+    pixels[3] = _mm_unpackhi_epi16(gg, gg);
+    SSE2StoreRGB(pixels, dest);
 }
 
-static void RGB2GrayscaleAlpha(unsigned char* src, unsigned char* dest){
-    dest[0] = AverageRGB(src);
-    dest[1] = 255;
+// 48 bytes of RGB -> 16 gray bytes
+static inline __m128i SSE2LoadRGBAsGray(const unsigned char* src) {
+    __m128i pixels[4];
+    SSE2LoadRGB(src, pixels);
+    __m128i lo = SSE2Divide3(_mm_packs_epi32(SSE2SumRGB(pixels[0]), SSE2SumRGB(pixels[1])));
+    __m128i hi = SSE2Divide3(_mm_packs_epi32(SSE2SumRGB(pixels[2]), SSE2SumRGB(pixels[3])));
+    return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+
+#if defined(TDOGL_BITMAP_NEON)
+static inline uint8x8_t NEONAverageRGB(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+    uint16x8_t sums = vaddw_u8(vaddl_u8(r, g), b);
+    uint16x4_t lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(sums), 0xAAAB), 16);
+    uint16x4_t hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(sums), 0xAAAB), 16);
+    return vmovn_u16(vshrq_n_u16(vcombine_u16(lo, hi), 1));
 }
 
-static void RGB2RGBA(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[1];
-    dest[2] = src[2];
-    dest[3] = 255;
+static inline uint8x16_t NEONAverageRGB(uint8x16_t r, uint8x16_t g, uint8x16_t b) {
+    return vcombine_u8(NEONAverageRGB(vget_low_u8(r), vget_low_u8(g), vget_low_u8(b)),
+                       NEONAverageRGB(vget_high_u8(r), vget_high_u8(g), vget_high_u8(b)));
 }
+#endif
 
-static void RGBA2Grayscale(unsigned char* src, unsigned char* dest){
-    dest[0] = AverageRGB(src);
+static void Grayscale2GrayscaleAlpha(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for(; i + 16 <= count; i += 16){
+        __m128i gray = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dest + i*2), _mm_unpacklo_epi8(gray, alpha));
+        _mm_storeu_si128((__m128i*)(dest + i*2 + 16), _mm_unpackhi_epi8(gray, alpha));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x2_t ga;
+        ga.val[0] = vld1q_u8(src + i);
+        ga.val[1] = vdupq_n_u8(255);
+        vst2q_u8(dest + i*2, ga);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*2 + 0] = src[i];
+        dest[i*2 + 1] = 255;
+    }
+}
+
+static void Grayscale2RGB(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 16 <= count; i += 16)
+        SSE2StoreGrayAsRGB(_mm_loadu_si128((const __m128i*)(src + i)), dest + i*3);
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x3_t rgb;
+        rgb.val[0] = rgb.val[1] = rgb.val[2] = vld1q_u8(src + i);
+        vst3q_u8(dest + i*3, rgb);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*3 + 0] = src[i];
+        dest[i*3 + 1] = src[i];
+        dest[i*3 + 2] = src[i];
+    }
+}
+
+static void Grayscale2RGBA(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for(; i + 16 <= count; i += 16){
+        __m128i gray = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i gg = _mm_unpacklo_epi8(gray, gray);
+        __m128i ga = _mm_unpacklo_epi8(gray, alpha);
+        _mm_storeu_si128((__m128i*)(dest + i*4), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 16), _mm_unpackhi_epi16(gg, ga));
+        gg = _mm_unpackhi_epi8(gray, gray);
+        ga = _mm_unpackhi_epi8(gray, alpha);
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 32), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 48), _mm_unpackhi_epi16(gg, ga));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgba.val[1] = rgba.val[2] = vld1q_u8(src + i);
+        rgba.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dest + i*4, rgba);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*4 + 0] = src[i];
+        dest[i*4 + 1] = src[i];
+        dest[i*4 + 2] = src[i];
+        dest[i*4 + 3] = 255;
+    }
+}
+
+static void GrayscaleAlpha2Grayscale(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i lowByte = _mm_set1_epi16(0xFF);
+    for(; i + 16 <= count; i += 16){
+        __m128i lo = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i*2)), lowByte);
+        __m128i hi = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i*2 + 16)), lowByte);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16)
+        vst1q_u8(dest + i, vld2q_u8(src + i*2).val[0]);
+#endif
+    for(; i < count; ++i)
+        dest[i] = src[i*2];
+}
+
+static void GrayscaleAlpha2RGB(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i lowByte = _mm_set1_epi16(0xFF);
+    for(; i + 16 <= count; i += 16){
+        __m128i lo = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i*2)), lowByte);
+        __m128i hi = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i*2 + 16)), lowByte);
+        SSE2StoreGrayAsRGB(_mm_packus_epi16(lo, hi), dest + i*3);
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x3_t rgb;
+        rgb.val[0] = rgb.val[1] = rgb.val[2] = vld2q_u8(src + i*2).val[0];
+        vst3q_u8(dest + i*3, rgb);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*3 + 0] = src[i*2];
+        dest[i*3 + 1] = src[i*2];
+        dest[i*3 + 2] = src[i*2];
+    }
+}
+
+static void GrayscaleAlpha2RGBA(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i lowByte = _mm_set1_epi16(0xFF);
+    for(; i + 8 <= count; i += 8){
+        __m128i ga = _mm_loadu_si128((const __m128i*)(src + i*2));
+        __m128i g = _mm_and_si128(ga, lowByte);
+        __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i*)(dest + i*4), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 16), _mm_unpackhi_epi16(gg, ga));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x2_t ga = vld2q_u8(src + i*2);
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgba.val[1] = rgba.val[2] = ga.val[0];
+        rgba.val[3] = ga.val[1];
+        vst4q_u8(dest + i*4, rgba);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*4 + 0] = src[i*2];
+        dest[i*4 + 1] = src[i*2];
+        dest[i*4 + 2] = src[i*2];
+        dest[i*4 + 3] = src[i*2 + 1];
+    }
+}
+
+static void RGB2Grayscale(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 16 <= count; i += 16)
+        _mm_storeu_si128((__m128i*)(dest + i), SSE2LoadRGBAsGray(src + i*3));
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x3_t rgb = vld3q_u8(src + i*3);
+        vst1q_u8(dest + i, NEONAverageRGB(rgb.val[0], rgb.val[1], rgb.val[2]));
+    }
+#endif
+    for(; i < count; ++i)
+        dest[i] = AverageRGB(src + i*3);
+}
+
+static void RGB2GrayscaleAlpha(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for(; i + 16 <= count; i += 16){
+        __m128i gray = SSE2LoadRGBAsGray(src + i*3);
+        _mm_storeu_si128((__m128i*)(dest + i*2), _mm_unpacklo_epi8(gray, alpha));
+        _mm_storeu_si128((__m128i*)(dest + i*2 + 16), _mm_unpackhi_epi8(gray, alpha));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x3_t rgb = vld3q_u8(src + i*3);
+        uint8x16x2_t ga;
+        ga.val[0] = NEONAverageRGB(rgb.val[0], rgb.val[1], rgb.val[2]);
+        ga.val[1] = vdupq_n_u8(255);
+        vst2q_u8(dest + i*2, ga);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*2 + 0] = AverageRGB(src + i*3);
+        dest[i*2 + 1] = 255;
+    }
+}
+
+static void RGB2RGBA(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for(; i + 16 <= count; i += 16){
+        __m128i pixels[4];
+        SSE2LoadRGB(src + i*3, pixels);
+        _mm_storeu_si128((__m128i*)(dest + i*4), _mm_or_si128(pixels[0], alpha));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 16), _mm_or_si128(pixels[1], alpha));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 32), _mm_or_si128(pixels[2], alpha));
+        _mm_storeu_si128((__m128i*)(dest + i*4 + 48), _mm_or_si128(pixels[3], alpha));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x3_t rgb = vld3q_u8(src + i*3);
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = rgb.val[2];
+        rgba.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dest + i*4, rgba);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*4 + 0] = src[i*3 + 0];
+        dest[i*4 + 1] = src[i*3 + 1];
+        dest[i*4 + 2] = src[i*3 + 2];
+        dest[i*4 + 3] = 255;
+    }
+}
+
+static void RGBA2Grayscale(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 16 <= count; i += 16){
+        __m128i s0 = SSE2SumRGB(_mm_loadu_si128((const __m128i*)(src + i*4)));
+        __m128i s1 = SSE2SumRGB(_mm_loadu_si128((const __m128i*)(src + i*4 + 16)));
+        __m128i s2 = SSE2SumRGB(_mm_loadu_si128((const __m128i*)(src + i*4 + 32)));
+        __m128i s3 = SSE2SumRGB(_mm_loadu_si128((const __m128i*)(src + i*4 + 48)));
+        __m128i lo = SSE2Divide3(_mm_packs_epi32(s0, s1));
+        __m128i hi = SSE2Divide3(_mm_packs_epi32(s2, s3));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x4_t rgba = vld4q_u8(src + i*4);
+        vst1q_u8(dest + i, NEONAverageRGB(rgba.val[0], rgba.val[1], rgba.val[2]));
+    }
+#endif
+    for(; i < count; ++i)
+        dest[i] = AverageRGB(src + i*4);
 }
 
-static void RGBA2GrayscaleAlpha(unsigned char* src, unsigned char* dest){
-    dest[0] = AverageRGB(src);
-    dest[1] = src[3];
+static void RGBA2GrayscaleAlpha(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 8 <= count; i += 8){
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(src + i*4));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(src + i*4 + 16));
+        __m128i gray = SSE2Divide3(_mm_packs_epi32(SSE2SumRGB(p0), SSE2SumRGB(p1)));
+        __m128i alpha = _mm_packs_epi32(_mm_srli_epi32(p0, 24), _mm_srli_epi32(p1, 24));
+        _mm_storeu_si128((__m128i*)(dest + i*2), _mm_or_si128(gray, _mm_slli_epi16(alpha, 8)));
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x4_t rgba = vld4q_u8(src + i*4);
+        uint8x16x2_t ga;
+        ga.val[0] = NEONAverageRGB(rgba.val[0], rgba.val[1], rgba.val[2]);
+        ga.val[1] = rgba.val[3];
+        vst2q_u8(dest + i*2, ga);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*2 + 0] = AverageRGB(src + i*4);
+        dest[i*2 + 1] = src[i*4 + 3];
+    }
 }
 
-static void RGBA2RGB(unsigned char* src, unsigned char* dest){
-    dest[0] = src[0];
-    dest[1] = src[1];
-    dest[2] = src[2];
+static void RGBA2RGB(const unsigned char* src, unsigned char* dest, unsigned count){
+    unsigned i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 16 <= count; i += 16){
+        __m128i pixels[4];
+        pixels[0] = _mm_loadu_si128((const __m128i*)(src + i*4));
+        pixels[1] = _mm_loadu_si128((const __m128i*)(src + i*4 + 16));
+        pixels[2] = _mm_loadu_si128((const __m128i*)(src + i*4 + 32));
+        pixels[3] = _mm_loadu_si128((const __m128i*)(src + i*4 + 48));
+        SSE2StoreRGB(pixels, dest + i*3);
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 16 <= count; i += 16){
+        uint8x16x4_t rgba = vld4q_u8(src + i*4);
+        uint8x16x3_t rgb;
+        rgb.val[0] = rgba.val[0];
+        rgb.val[1] = rgba.val[1];
+        rgb.val[2] = rgba.val[2];
+        vst3q_u8(dest + i*3, rgb);
+    }
+#endif
+    for(; i < count; ++i){
+        dest[i*3 + 0] = src[i*4 + 0];
+        dest[i*3 + 1] = src[i*4 + 1];
+        dest[i*3 + 2] = src[i*4 + 2];
+    }
 }
 
-typedef void(*FormatConverterFunc)(unsigned char*, unsigned char*);
+typedef void(*FormatConverterFunc)(const unsigned char* src, unsigned char* dest, unsigned count);
 
 static FormatConverterFunc ConverterFuncForFormats(Bitmap::Format srcFormat, Bitmap::Format destFormat){
     if(srcFormat == destFormat)
@@ -152,6 +495,114 @@ static FormatConverterFunc ConverterFuncForFormats(Bitmap::Format srcFormat, Bit
 }
 
 
+/*
+ * Rotation kernels
+ *
+ * The image is rotated one band of source rows at a time, and each band is split
+ * into square tiles, so the source rows and destination rows being touched stay
+ * in cache. Different bands write to different columns of the destination, so
+ * the bands can be rotated on different threads.
+ */
+
+//side length of the tiles, in pixels. A tile of RGBA pixels is 16KB.
+static const unsigned kRotateTileSize = 64;
+
+//images smaller than this many pixels aren't worth starting threads for
+static const size_t kMinParallelPixels = 512 * 512;
+
+template<unsigned Size>
+struct PixelBytes {
+    unsigned char bytes[Size];
+};
+
+//rotates the rows [rowBegin, rowEnd) of `src` into `dest`, for any pixel size
+template<unsigned Size>
+static void RotateBand(const unsigned char* src, unsigned char* dest, unsigned width, unsigned height, unsigned rowBegin, unsigned rowEnd) {
+    typedef PixelBytes<Size> Pixel;
+    const Pixel* srcPixels = (const Pixel*)src;
+    Pixel* destPixels = (Pixel*)dest;
+    
+    for(unsigned colTile = 0; colTile < width; colTile += kRotateTileSize){
+        unsigned colEnd = std::min(width, colTile + kRotateTileSize);
+        for(unsigned col = colTile; col < colEnd; ++col){
+            //source column `col` becomes destination row `width - col - 1`
+            Pixel* destRow = destPixels + (size_t)(width - col - 1) * height;
+            for(unsigned row = rowBegin; row < rowEnd; ++row)
+                destRow[row] = srcPixels[(size_t)row * width + col];
+        }
+    }
+}
+
+#if defined(TDOGL_BITMAP_SSE2) || defined(TDOGL_BITMAP_NEON)
+//RGBA pixels are rotated in blocks of 4x4, transposed in vector registers
+template<>
+void RotateBand<4>(const unsigned char* src, unsigned char* dest, unsigned width, unsigned height, unsigned rowBegin, unsigned rowEnd) {
+    const size_t srcStride = (size_t)width * 4;
+    const size_t destStride = (size_t)height * 4;
+    unsigned blockRowEnd = rowBegin + (rowEnd - rowBegin) / 4 * 4;
+    unsigned blockColEnd = width / 4 * 4;
+    
+    for(unsigned colTile = 0; colTile < blockColEnd; colTile += kRotateTileSize){
+        unsigned colEnd = std::min(blockColEnd, colTile + kRotateTileSize);
+        for(unsigned row = rowBegin; row < blockRowEnd; row += 4){
+            const unsigned char* s = src + row * srcStride;
+            for(unsigned col = colTile; col < colEnd; col += 4){
+                unsigned char* d = dest + (size_t)(width - col - 1) * destStride + row * 4;
+#if defined(TDOGL_BITMAP_SSE2)
+                __m128i r0 = _mm_loadu_si128((const __m128i*)(s + col * 4));
+                __m128i r1 = _mm_loadu_si128((const __m128i*)(s + srcStride + col * 4));
+                __m128i r2 = _mm_loadu_si128((const __m128i*)(s + 2 * srcStride + col * 4));
+                __m128i r3 = _mm_loadu_si128((const __m128i*)(s + 3 * srcStride + col * 4));
+                __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+                __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+                __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+                __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+                _mm_storeu_si128((__m128i*)d, _mm_unpacklo_epi64(t0, t1));
+                _mm_storeu_si128((__m128i*)(d - destStride), _mm_unpackhi_epi64(t0, t1));
+                _mm_storeu_si128((__m128i*)(d - 2 * destStride), _mm_unpacklo_epi64(t2, t3));
+                _mm_storeu_si128((__m128i*)(d - 3 * destStride), _mm_unpackhi_epi64(t2, t3));
+#else
+                uint32x4_t r0 = vreinterpretq_u32_u8(vld1q_u8(s + col * 4));
+                uint32x4_t r1 = vreinterpretq_u32_u8(vld1q_u8(s + srcStride + col * 4));
+                uint32x4_t r2 = vreinterpretq_u32_u8(vld1q_u8(s + 2 * srcStride + col * 4));
+                uint32x4_t r3 = vreinterpretq_u32_u8(vld1q_u8(s + 3 * srcStride + col * 4));
+                uint32x4x2_t t01 = vtrnq_u32(r0, r1);
+                uint32x4x2_t t23 = vtrnq_u32(r2, r3);
+                vst1q_u8(d, vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]))));
+                vst1q_u8(d - destStride, vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]))));
+                vst1q_u8(d - 2 * destStride, vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]))));
+                vst1q_u8(d - 3 * destStride, vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]))));
+#endif
+            }
+        }
+    }
+    
+    //the columns and rows left over from the 4x4 blocks
+    typedef PixelBytes<4> Pixel;
+    const Pixel* srcPixels = (const Pixel*)src;
+    Pixel* destPixels = (Pixel*)dest;
+    for(unsigned col = 0; col < width; ++col){
+        Pixel* destRow = destPixels + (size_t)(width - col - 1) * height;
+        unsigned row = (col < blockColEnd) ? blockRowEnd : rowBegin;
+        for(; row < rowEnd; ++row)
+            destRow[row] = srcPixels[(size_t)row * width + col];
+    }
+}
+#endif
+
+typedef void(*RotateBandFunc)(const unsigned char*, unsigned char*, unsigned, unsigned, unsigned, unsigned);
+
+static RotateBandFunc RotateBandFuncForFormat(Bitmap::Format format) {
+    switch(format){
+        case Bitmap::Format_Grayscale: return RotateBand<1>;
+        case Bitmap::Format_GrayscaleAlpha: return RotateBand<2>;
+        case Bitmap::Format_RGB: return RotateBand<3>;
+        case Bitmap::Format_RGBA: return RotateBand<4>;
+        default: throw std::runtime_error("Unhandled bitmap format");
+    }
+}
+
+
 /*
  * Misc funcs
  */
@@ -162,14 +613,37 @@ inline unsigned GetPixelOffset(unsigned col, unsigned row, unsigned width, unsig
 
 inline bool RectsOverlap(unsigned srcCol, unsigned srcRow, unsigned destCol, unsigned destRow, unsigned width, unsigned height){
     unsigned colDiff = srcCol > destCol ? srcCol - destCol : destCol - srcCol;
-    if(colDiff < width)
-        return true;
-    
     unsigned rowDiff = srcRow > destRow ? srcRow - destRow : destRow - srcRow;
-    if(rowDiff < height)
+    return colDiff < width && rowDiff < height;
+}
+
+static bool ViewsOverlap(const BitmapView& a, const BitmapView& b) {
+    const unsigned char* aStart = a.rowPointer(0);
+    const unsigned char* bStart = b.rowPointer(0);
+    const unsigned char* aEnd = a.rowPointer(a.height() - 1) + (size_t)a.width() * a.format();
+    const unsigned char* bEnd = b.rowPointer(b.height() - 1) + (size_t)b.width() * b.format();
+    if(aEnd <= bStart || bEnd <= aStart)
+        return false;
+    
+    //different strides overlapping the same memory. Too hard to tell, so assume they overlap.
+    if(a.rowStride() != b.rowStride() || a.format() != b.format() || a.width() != b.width() || a.height() != b.height())
         return true;
     
-    return false;
+    //same shaped rects in the same image. Find the row and column that b starts at, relative to a.
+    size_t stride = a.rowStride();
+    size_t rowBytes = (size_t)a.width() * a.format();
+    long long diff = (long long)(bStart - aStart);
+    long long rowDiff = diff / (long long)stride;
+    long long byteDiff = diff - rowDiff * (long long)stride;
+    if(byteDiff < 0){
+        byteDiff += stride;
+        rowDiff -= 1;
+    }
+    //b starts byteDiff bytes right of a on row rowDiff, or (stride - byteDiff) bytes left of it on the next row
+    long long height = a.height();
+    bool rightOverlaps = (size_t)byteDiff < rowBytes && rowDiff < height && rowDiff > -height;
+    bool leftOverlaps = stride - (size_t)byteDiff < rowBytes && rowDiff + 1 < height && rowDiff + 1 > -height;
+    return rightOverlaps || leftOverlaps;
 }
 
 
@@ -177,6 +651,10 @@ inline bool RectsOverlap(unsigned srcCol, unsigned srcRow, unsigned destCol, uns
  * Bitmap class
  */
 
+// set with Bitmap::setLoadLimits. Atomic because images can be loaded on any thread.
+static std::atomic<unsigned> gLoadLimitDimension(0);
+static std::atomic<size_t> gLoadLimitBytes(0);
+
 Bitmap::Bitmap(unsigned width, 
                unsigned height, 
                Format format,
@@ -186,20 +664,86 @@ Bitmap::Bitmap(unsigned width,
     _set(width, height, format, pixels);
 }
 
+Bitmap::Bitmap(const BitmapView& view) :
+    _pixels(NULL)
+{
+    _set(view.width(), view.height(), view.format(), NULL);
+    this->view().copyFrom(view);
+}
+
+Bitmap::Bitmap() :
+    _format(Format_RGBA),
+    _width(0),
+    _height(0),
+    _pixels(NULL)
+{
+}
+
 Bitmap::~Bitmap() {
-    if(_pixels) free(_pixels);
+    PixelAllocator::current().deallocate(_pixels);
 }
 
-Bitmap Bitmap::bitmapFromFile(std::string filePath) {    
+Bitmap Bitmap::bitmapFromFile(std::string filePath, bool flipVertically) {
     int width, height, channels;
     unsigned char* pixels = stbi_load(filePath.c_str(), &width, &height, &channels, 0);
     if(!pixels) throw std::runtime_error(stbi_failure_reason());
     
-    Bitmap bmp(width, height, (Format)channels, pixels);
-    stbi_image_free(pixels);
+    //stb_image allocates with the pixel allocator, so the bitmap can free the buffer itself.
+    //Shrink before flipping, so the flip has fewer rows to move.
+    Bitmap bmp;
+    bmp._adopt(width, height, (Format)channels, pixels);
+    bmp.shrinkToFit(gLoadLimitDimension, gLoadLimitBytes);
+    if(flipVertically)
+        bmp.flipVertically();
+    return bmp;
+}
+
+Bitmap Bitmap::bitmapFromMemory(const unsigned char* data, size_t size, bool flipVertically) {
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(data, (int)size, &width, &height, &channels, 0);
+    if(!pixels) throw std::runtime_error(stbi_failure_reason());
+    
+    Bitmap bmp;
+    bmp._adopt(width, height, (Format)channels, pixels);
+    bmp.shrinkToFit(gLoadLimitDimension, gLoadLimitBytes);
+    if(flipVertically)
+        bmp.flipVertically();
     return bmp;
 }
 
+std::vector<BitmapLoadResult> Bitmap::bitmapsFromFiles(const std::vector<std::string>& filePaths,
+                                                       bool flipVertically)
+{
+    //stb_image fills in its default zlib tables the first time it decodes a PNG.
+    //Do it now, so the worker threads don't race to write them.
+    if(!stbi__zdefault_distance[31])
+        stbi__init_zdefaults();
+    
+    std::vector<BitmapLoadResult> results(filePaths.size());
+    ParallelFor((unsigned)filePaths.size(), [&](unsigned i){
+        results[i].filePath = filePaths[i];
+        try {
+            results[i].bitmap.reset(new Bitmap(bitmapFromFile(filePaths[i], flipVertically)));
+        } catch(const std::exception& e) {
+            results[i].error = e.what();
+        }
+    });
+    return results;
+}
+
+void Bitmap::setLoadLimits(unsigned maxDimension, size_t maxBytes) {
+    gLoadLimitDimension = maxDimension;
+    gLoadLimitBytes = maxBytes;
+}
+
+unsigned Bitmap::loadLimitDimension() {
+    return gLoadLimitDimension;
+}
+
+size_t Bitmap::loadLimitBytes() {
+    return gLoadLimitBytes;
+}
+
 Bitmap::Bitmap(const Bitmap& other) :
     _pixels(NULL)
 {
@@ -211,6 +755,31 @@ Bitmap& Bitmap::operator = (const Bitmap& other) {
     return *this;
 }
 
+Bitmap::Bitmap(Bitmap&& other) :
+    _format(other._format),
+    _width(other._width),
+    _height(other._height),
+    _pixels(other._pixels)
+{
+    other._width = 0;
+    other._height = 0;
+    other._pixels = NULL;
+}
+
+Bitmap& Bitmap::operator = (Bitmap&& other) {
+    if(this != &other){
+        PixelAllocator::current().deallocate(_pixels);
+        _format = other._format;
+        _width = other._width;
+        _height = other._height;
+        _pixels = other._pixels;
+        other._width = 0;
+        other._height = 0;
+        other._pixels = NULL;
+    }
+    return *this;
+}
+
 unsigned int Bitmap::width() const {
     return _width;
 }
@@ -239,35 +808,34 @@ void Bitmap::setPixel(unsigned int column, unsigned int row, const unsigned char
     memcpy(myPixel, pixel, _format);
 }
 
+BitmapView Bitmap::view() const {
+    return BitmapView(_pixels, _width, _height, _format);
+}
+
+BitmapView Bitmap::view(unsigned col, unsigned row, unsigned width, unsigned height) const {
+    return view().subview(col, row, width, height);
+}
+
 void Bitmap::flipVertically() {
-    unsigned long rowSize = _format*_width;
-    unsigned char* rowBuffer = new unsigned char[rowSize];
-    unsigned halfRows = _height / 2;
-    
-    for(unsigned rowIdx = 0; rowIdx < halfRows; ++rowIdx){
-        unsigned char* row = _pixels + GetPixelOffset(0, rowIdx, _width, _height, _format);
-        unsigned char* oppositeRow = _pixels + GetPixelOffset(0, _height - rowIdx - 1, _width, _height, _format);
-        
-        memcpy(rowBuffer, row, rowSize);
-        memcpy(row, oppositeRow, rowSize);
-        memcpy(oppositeRow, rowBuffer, rowSize);
-    }
-    
-    delete rowBuffer;
+    view().flipVertically();
 }
 
 void Bitmap::rotate90CounterClockwise() {
-    unsigned char* newPixels = (unsigned char*) malloc(_format*_width*_height);
+    unsigned char* newPixels = (unsigned char*)PixelAllocator::current().allocate(_format*_width*_height);
+    if(!newPixels) throw std::runtime_error("Out of memory for bitmap pixels");
     
-    for(unsigned row = 0; row < _height; ++row){
-        for(unsigned col = 0; col < _width; ++col){
-            unsigned srcOffset = GetPixelOffset(col, row, _width, _height, _format);
-            unsigned destOffset = GetPixelOffset(row, _width - col - 1, _height, _width, _format);
-            memcpy(newPixels + destOffset, _pixels + srcOffset, _format); //copy one pixel
-        }
+    RotateBandFunc rotateBand = RotateBandFuncForFormat(_format);
+    unsigned bandCount = (_height + kRotateTileSize - 1) / kRotateTileSize;
+    if((size_t)_width * _height < kMinParallelPixels){
+        rotateBand(_pixels, newPixels, _width, _height, 0, _height);
+    } else {
+        ParallelFor(bandCount, [&](unsigned band){
+            unsigned rowBegin = band * kRotateTileSize;
+            rotateBand(_pixels, newPixels, _width, _height, rowBegin, std::min(_height, rowBegin + kRotateTileSize));
+        });
     }
     
-    free(_pixels);
+    PixelAllocator::current().deallocate(_pixels);
     _pixels = newPixels;
     
     unsigned swapTmp = _height;
@@ -291,31 +859,30 @@ void Bitmap::copyRectFromBitmap(const Bitmap& src,
     if(width == 0 || height == 0)
         throw std::runtime_error("Can't copy zero height/width rectangle");
     
-    if(srcCol + width >= src.width() || srcRow + height >= src.height())
+    if(srcCol + width > src.width() || srcRow + height > src.height())
         throw std::runtime_error("Rectangle doesn't fit within source bitmap");
 
-    if(destCol + width >= _width || destRow + height >= _height)
+    if(destCol + width > _width || destRow + height > _height)
         throw std::runtime_error("Rectangle doesn't fit within destination bitmap");
     
     if(_pixels == src._pixels && RectsOverlap(srcCol, srcRow, destCol, destRow, width, height))
         throw std::runtime_error("Source and destination are the same bitmap, and rects overlap. Not allowed!");
     
-    FormatConverterFunc converter = NULL;
-    if(_format != src._format)
-        converter = ConverterFuncForFormats(_format, src._format);
-    
-    for(unsigned row = 0; row < height; ++row){
-        for(unsigned col = 0; col < width; ++col){
-            unsigned char* srcPixel = src._pixels + GetPixelOffset(srcCol + col, srcRow + row, src._width, src._height, src._format);
-            unsigned char* destPixel = _pixels + GetPixelOffset(destCol + col, destRow + row, _width, _height, _format);
-            
-            if(converter){
-                converter(srcPixel, destPixel);
-            } else {
-                memcpy(destPixel, srcPixel, _format);
-            }
-        }
+    view(destCol, destRow, width, height).copyFrom(src.view(srcCol, srcRow, width, height));
+}
+
+void Bitmap::_adopt(unsigned width, unsigned height, Format format, unsigned char* pixels) {
+    if(format <= 0 || format > 4){
+        //the buffer is ours as soon as this is called, even if it can't be used
+        PixelAllocator::current().deallocate(pixels);
+        throw std::runtime_error("Invalid bitmap format");
     }
+    
+    PixelAllocator::current().deallocate(_pixels);
+    _width = width;
+    _height = height;
+    _format = format;
+    _pixels = pixels;
 }
 
 void Bitmap::_set(unsigned width, 
@@ -327,17 +894,15 @@ void Bitmap::_set(unsigned width,
     if(height == 0) throw std::runtime_error("Zero height bitmap");
     if(format <= 0 || format > 4) throw std::runtime_error("Invalid bitmap format");
 
+    size_t newSize = (size_t)width * height * format;
+    unsigned char* newPixels = (unsigned char*)PixelAllocator::current().reallocate(_pixels, newSize);
+    if(!newPixels) throw std::runtime_error("Out of memory for bitmap pixels");
+    
+    _pixels = newPixels;
     _width = width;
     _height = height;
     _format = format;
     
-    size_t newSize = _width * _height * _format;
-    if(_pixels){
-        _pixels = (unsigned char*)realloc(_pixels, newSize);
-    } else {
-        _pixels = (unsigned char*)malloc(newSize);
-    }
-    
     if(pixels)
         memcpy(_pixels, pixels, newSize);
 }
@@ -352,3 +917,131 @@ void Bitmap::_set(unsigned width,
 
 
 
+
+
+/*
+ * BitmapView class
+ */
+
+BitmapView::BitmapView(unsigned char* pixels,
+                       unsigned width,
+                       unsigned height,
+                       Bitmap::Format format,
+                       size_t rowStride) :
+    _pixels(pixels),
+    _width(width),
+    _height(height),
+    _format(format),
+    _rowStride(rowStride ? rowStride : (size_t)width * format)
+{
+    if(!pixels) throw std::runtime_error("NULL bitmap view pixels");
+    if(width == 0 || height == 0) throw std::runtime_error("Zero width/height bitmap view");
+    if(format <= 0 || format > 4) throw std::runtime_error("Invalid bitmap format");
+    if(_rowStride < (size_t)width * format) throw std::runtime_error("Bitmap view row stride is smaller than a row");
+}
+
+BitmapView::BitmapView(const Bitmap& bitmap) :
+    _pixels(bitmap.pixelBuffer()),
+    _width(bitmap.width()),
+    _height(bitmap.height()),
+    _format(bitmap.format()),
+    _rowStride((size_t)bitmap.width() * bitmap.format())
+{
+}
+
+unsigned BitmapView::width() const {
+    return _width;
+}
+
+unsigned BitmapView::height() const {
+    return _height;
+}
+
+Bitmap::Format BitmapView::format() const {
+    return _format;
+}
+
+size_t BitmapView::rowStride() const {
+    return _rowStride;
+}
+
+bool BitmapView::isContiguous() const {
+    return _rowStride == (size_t)_width * _format;
+}
+
+unsigned char* BitmapView::rowPointer(unsigned row) const {
+    return _pixels + row * _rowStride;
+}
+
+unsigned char* BitmapView::getPixel(unsigned column, unsigned row) const {
+    if(column >= _width || row >= _height)
+        throw std::runtime_error("Pixel coordinate out of bounds");
+    
+    return rowPointer(row) + (size_t)column * _format;
+}
+
+BitmapView BitmapView::subview(unsigned col, unsigned row, unsigned width, unsigned height) const {
+    if(width == 0 || height == 0)
+        throw std::runtime_error("Zero width/height bitmap view");
+    if(col + width > _width || row + height > _height)
+        throw std::runtime_error("Rectangle doesn't fit within bitmap view");
+    
+    return BitmapView(rowPointer(row) + (size_t)col * _format, width, height, _format, _rowStride);
+}
+
+void BitmapView::flipVertically() const {
+    size_t rowSize = (size_t)_width * _format;
+    unsigned halfRows = _height / 2;
+    
+    auto swapRows = [&](unsigned rowBegin, unsigned rowEnd){
+        for(unsigned rowIdx = rowBegin; rowIdx < rowEnd; ++rowIdx){
+            unsigned char* row = rowPointer(rowIdx);
+            unsigned char* oppositeRow = rowPointer(_height - rowIdx - 1);
+            
+            //swap in place, so no row buffer needs to be allocated
+            std::swap_ranges(row, row + rowSize, oppositeRow);
+        }
+    };
+    
+    if((size_t)_width * _height < kMinParallelPixels){
+        swapRows(0, halfRows);
+    } else {
+        //each worker swaps its own group of row pairs
+        const unsigned rowsPerGroup = 32;
+        ParallelFor((halfRows + rowsPerGroup - 1) / rowsPerGroup, [&](unsigned group){
+            unsigned rowBegin = group * rowsPerGroup;
+            swapRows(rowBegin, std::min(halfRows, rowBegin + rowsPerGroup));
+        });
+    }
+}
+
+void BitmapView::copyFrom(const BitmapView& src) const {
+    if(src._width != _width || src._height != _height)
+        throw std::runtime_error("Can't copy between bitmap views of different sizes");
+    if(ViewsOverlap(src, *this))
+        throw std::runtime_error("Source and destination bitmap views overlap. Not allowed!");
+    
+    const unsigned char* srcRowPtr = src._pixels;
+    unsigned char* destRowPtr = _pixels;
+    
+    if(_format == src._format){
+        size_t rowSize = (size_t)_width * _format;
+        if(isContiguous() && src.isContiguous()){
+            //both views are tightly packed, so the rows are contiguous
+            memcpy(destRowPtr, srcRowPtr, rowSize * _height);
+            return;
+        }
+        for(unsigned row = 0; row < _height; ++row){
+            memcpy(destRowPtr, srcRowPtr, rowSize);
+            srcRowPtr += src._rowStride;
+            destRowPtr += _rowStride;
+        }
+    } else {
+        FormatConverterFunc converter = ConverterFuncForFormats(src._format, _format);
+        for(unsigned row = 0; row < _height; ++row){
+            converter(srcRowPtr, destRowPtr, _width);
+            srcRowPtr += src._rowStride;
+            destRowPtr += _rowStride;
+        }
+    }
+}
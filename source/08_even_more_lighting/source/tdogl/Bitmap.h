@@ -19,9 +19,14 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
 
 namespace tdogl {
     
+    struct BitmapLoadResult;
+    class BitmapView;
+    
     /**
      A bitmap image (i.e. a grid of pixels).
      
@@ -42,6 +47,16 @@ namespace tdogl {
             Format_RGBA = 4 /**< four channels: red, green, blue, alpha */
         };
         
+        /**
+         The filter used when making a resized copy of a bitmap.
+         */
+        enum Filter {
+            Filter_Box, /**< averages the source pixels under each new pixel. Fast, but slightly blurry */
+            Filter_Kaiser, /**< Kaiser windowed sinc. Slower, but keeps small mipmaps sharp */
+            Filter_Bilinear, /**< triangle filter. Smooth, and fast at any scale */
+            Filter_Lanczos /**< three lobe Lanczos windowed sinc. The sharpest, but can ring around hard edges */
+        };
+        
         /**
          Creates a new image with the specified width, height and format.
          
@@ -52,12 +67,70 @@ namespace tdogl {
                unsigned height, 
                Format format,
                const unsigned char* pixels = NULL);
+        
+        /**
+         Creates a new image with a copy of the pixels in the view. The new image
+         has the same size and format as the view.
+         */
+        explicit Bitmap(const BitmapView& view);
         ~Bitmap();
         
         /**
          Tries to load the given file into a tdogl::Bitmap.
+         
+         The bitmap takes ownership of the buffer that the image decoder
+         allocated, so no extra copy of the pixels is made.
+         
+         @param filePath  The path to the image file
+         @param flipVertically  If true, the rows are reversed after decoding, with
+                                the same in-place pass as `flipVertically`. It is
+                                done after any shrinking for the load limits, so
+                                there are fewer rows to move.
+         */
+        static Bitmap bitmapFromFile(std::string filePath, bool flipVertically = false);
+        
+        /**
+         Same as `bitmapFromFile`, but decodes an image file that has already been
+         read into memory.
+         
+         @param data  The contents of the image file
+         @param size  The size of `data` in bytes
+         @param flipVertically  Same as the argument to `bitmapFromFile`
+         */
+        static Bitmap bitmapFromMemory(const unsigned char* data, size_t size, bool flipVertically = false);
+        
+        /**
+         Loads many files at once, decoding them in parallel on tdogl::WorkerThreadCount()
+         threads.
+         
+         A file that fails to load does not stop the others from loading. Check
+         each result to see whether its file loaded.
+         
+         @param filePaths  The paths of the image files to load
+         @param flipVertically  Same as the argument to `bitmapFromFile`
+         @result One result per file, in the same order as `filePaths`
+         */
+        static std::vector<BitmapLoadResult> bitmapsFromFiles(const std::vector<std::string>& filePaths,
+                                                              bool flipVertically = false);
+        
+        /**
+         Sets the biggest bitmap that `bitmapFromFile`, `bitmapFromMemory` and
+         `bitmapsFromFiles` will return. Bigger images are shrunk with `shrinkToFit`
+         as they are loaded, so one set of high resolution images can be used on
+         machines with less video memory.
+         
+         Applies to every thread. Both limits are 0 (unlimited) by default.
+         
+         @param maxDimension  The maximum width and height in pixels, or 0 for no limit
+         @param maxBytes  The maximum size of the pixel data in bytes, or 0 for no limit
          */
-        static Bitmap bitmapFromFile(std::string filePath);
+        static void setLoadLimits(unsigned maxDimension, size_t maxBytes = 0);
+        
+        /** the maximum width and height set with `setLoadLimits`, or 0 */
+        static unsigned loadLimitDimension();
+        
+        /** the maximum pixel data size set with `setLoadLimits`, or 0 */
+        static size_t loadLimitBytes();
                 
         /** width in pixels */
         unsigned width() const;
@@ -75,6 +148,9 @@ namespace tdogl {
          by the `Format` of the image. The pointer points to all the columns of
          the top row of the image, followed by each remaining row down to the bottom.
          i.e. c0r0, c1r0, c2r0, ..., c0r1, c1r1, c2r1, etc
+         
+         The buffer is allocated by tdogl::PixelAllocator, so it starts on a
+         PixelAlignment byte boundary.
          */
         unsigned char* pixelBuffer() const;
         
@@ -92,6 +168,17 @@ namespace tdogl {
          */
         void setPixel(unsigned int column, unsigned int row, const unsigned char* pixel);
         
+        /** A view of the whole bitmap */
+        BitmapView view() const;
+        
+        /**
+         A view of a rectangle inside the bitmap. Nothing is copied, so changes
+         made through the view change the bitmap.
+         
+         @throws std::exception if the rectangle doesn't fit within the bitmap
+         */
+        BitmapView view(unsigned col, unsigned row, unsigned width, unsigned height) const;
+        
         /**
          Reverses the row order of the pixels, so the bitmap will be upside down.
          */
@@ -123,20 +210,169 @@ namespace tdogl {
                                 unsigned width,
                                 unsigned height);
         
+        /**
+         Makes the mipmaps for this bitmap. 
+         
+         The first mipmap is half the width and height of this bitmap (rounded
+         down), and each one after that is half the size again, down to 1x1.
+         This bitmap is not included, it is mip level 0.
+         
+         @param filter  The filter to shrink each level with
+         @param srgb  If true, the color channels of RGB and RGBA bitmaps are
+                      treated as sRGB, and are filtered in linear space. This
+                      matches the internal formats that tdogl::Texture uses.
+                      Alpha and grayscale channels are always linear.
+         */
+        std::vector<Bitmap> mipmaps(Filter filter = Filter_Box, bool srgb = true) const;
+        
+        /**
+         Makes only the next mip level down from this bitmap, which is half the
+         width and height (rounded down, but never less than 1).
+         
+         Takes the same parameters as `mipmaps`.
+         */
+        Bitmap mipmap(Filter filter = Filter_Box, bool srgb = true) const;
+        
+        /**
+         Makes a copy of this bitmap scaled to the given size, which can be bigger
+         or smaller. Large bitmaps are resampled on tdogl::WorkerThreadCount() threads.
+         
+         @param width  The new width in pixels
+         @param height  The new height in pixels
+         @param filter  The filter to scale with
+         @param srgb  Same as the argument to `mipmaps`
+         */
+        Bitmap resized(unsigned width, unsigned height, Filter filter = Filter_Lanczos, bool srgb = true) const;
+        
+        /**
+         Shrinks the bitmap so that it fits within the given limits, keeping the
+         aspect ratio. Does nothing if it already fits.
+         
+         @param maxDimension  The maximum width and height in pixels, or 0 for no limit
+         @param maxBytes  The maximum size of the pixel data in bytes, or 0 for no limit
+         @param filter  The filter to shrink with
+         @param srgb  Same as the argument to `mipmaps`
+         @result true if the bitmap was shrunk
+         */
+        bool shrinkToFit(unsigned maxDimension, size_t maxBytes = 0, Filter filter = Filter_Lanczos, bool srgb = true);
+        
         /** Copy constructor */
         Bitmap(const Bitmap& other);
         
         /** Assignment operator */
         Bitmap& operator = (const Bitmap& other);
         
+        /** Move constructor. `other` is left empty and must not be used afterwards. */
+        Bitmap(Bitmap&& other);
+        
+        /** Move assignment operator. `other` is left empty and must not be used afterwards. */
+        Bitmap& operator = (Bitmap&& other);
+        
     private:
         Format _format;
         unsigned _width;
         unsigned _height;
         unsigned char* _pixels;
         
+        Bitmap();
+        void _adopt(unsigned width, unsigned height, Format format, unsigned char* pixels);
+        void _resampleInto(Bitmap& dest, Filter filter, bool srgb) const;
         void _set(unsigned width, unsigned height, Format format, const unsigned char* pixels);
         static void _getPixelOffset(unsigned col, unsigned row, unsigned width, unsigned height, Format format);
     };
     
+    /**
+     A rectangle of pixels in memory that belongs to something else, like a
+     tdogl::Bitmap or a mapped buffer.
+     
+     The rows of a view don't have to be tightly packed. Each row starts
+     `rowStride` bytes after the previous one, so a view can be a sub-rectangle
+     of a larger image. Making and copying views never allocates or copies
+     pixels, and the memory must stay valid for as long as the view is used.
+     
+     A tdogl::Bitmap converts to a view of the whole bitmap automatically.
+     */
+    class BitmapView {
+    public:
+        /**
+         @param pixels  Pointer to the first pixel of the top row
+         @param width  Width in pixels
+         @param height  Height in pixels
+         @param format  The pixel format
+         @param rowStride  Bytes from the start of one row to the start of the
+                           next, or 0 if the rows are tightly packed
+         */
+        BitmapView(unsigned char* pixels,
+                   unsigned width,
+                   unsigned height,
+                   Bitmap::Format format,
+                   size_t rowStride = 0);
+        
+        /** A view of the whole bitmap */
+        BitmapView(const Bitmap& bitmap);
+        
+        /** width in pixels */
+        unsigned width() const;
+        
+        /** height in pixels */
+        unsigned height() const;
+        
+        /** the pixel format */
+        Bitmap::Format format() const;
+        
+        /** bytes from the start of one row to the start of the next */
+        size_t rowStride() const;
+        
+        /** true if the rows are tightly packed, with no gaps between them */
+        bool isContiguous() const;
+        
+        /** pointer to the first pixel of the given row */
+        unsigned char* rowPointer(unsigned row) const;
+        
+        /** pointer to the pixel at the given coordinates */
+        unsigned char* getPixel(unsigned column, unsigned row) const;
+        
+        /**
+         A view of a rectangle inside this view.
+         
+         @throws std::exception if the rectangle doesn't fit within this view
+         */
+        BitmapView subview(unsigned col, unsigned row, unsigned width, unsigned height) const;
+        
+        /**
+         Reverses the row order of the pixels in the view, in place.
+         */
+        void flipVertically() const;
+        
+        /**
+         Copies the pixels of another view of the same size into this view,
+         converting them to this view's format if they are different.
+         
+         @throws std::exception if the sizes are different, or if the views
+                 overlap in memory
+         */
+        void copyFrom(const BitmapView& src) const;
+        
+    private:
+        unsigned char* _pixels;
+        unsigned _width;
+        unsigned _height;
+        Bitmap::Format _format;
+        size_t _rowStride;
+    };
+    
+    /**
+     The result of loading a single file with tdogl::Bitmap::bitmapsFromFiles.
+     */
+    struct BitmapLoadResult {
+        /** The path that was loaded */
+        std::string filePath;
+        
+        /** The loaded bitmap, or NULL if loading failed */
+        std::unique_ptr<Bitmap> bitmap;
+        
+        /** Why loading failed, or empty if it succeeded */
+        std::string error;
+    };
+    
 }
@@ -0,0 +1,440 @@
+/*
+ tdogl::Bitmap resampling
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "Bitmap.h"
+#include "Parallel.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TDOGL_BITMAP_SSE2
+    #include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define TDOGL_BITMAP_NEON
+    #include <arm_neon.h>
+#endif
+
+using namespace tdogl;
+
+// resampling costs a lot more per pixel than copying, so it's worth spreading over threads sooner
+static const size_t kMinParallelPixels = 256 * 256;
+static const unsigned kMinRowsPerBand = 16;
+
+
+/*
+ * Colour space conversion
+ *
+ * Filtering is done on floats in linear space. sRGB channels are converted with
+ * lookup tables in both directions: 256 entries on the way in, and 65536 entries
+ * (indexed by 16 bit linear intensity) on the way out, which is finer than the
+ * smallest step between sRGB values.
+ */
+
+static float SRGBToLinear(float c) {
+    return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSRGB(float c) {
+    return (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+namespace {
+    struct ColorTables {
+        float srgbToLinear[256];
+        float byteToFloat[256];
+        unsigned char linearToSRGB[65536];
+
+        ColorTables() {
+            for(unsigned i = 0; i < 256; ++i){
+                srgbToLinear[i] = SRGBToLinear(i / 255.0f);
+                byteToFloat[i] = i / 255.0f;
+            }
+            for(unsigned i = 0; i < 65536; ++i)
+                linearToSRGB[i] = (unsigned char)(LinearToSRGB(i / 65535.0f) * 255.0f + 0.5f);
+        }
+    };
+}
+
+static const ColorTables& Tables() {
+    static const ColorTables tables;
+    return tables;
+}
+
+// number of leading channels that are sRGB encoded, matching the texture formats chosen by tdogl::Texture
+static unsigned SRGBChannelCount(Bitmap::Format format, bool srgb) {
+    if(!srgb) return 0;
+    return (format == Bitmap::Format_RGB || format == Bitmap::Format_RGBA) ? 3 : 0;
+}
+
+static void RowToLinear(const unsigned char* src, float* dest, unsigned width, unsigned channels, unsigned srgbChannels) {
+    const ColorTables& t = Tables();
+    for(unsigned x = 0; x < width; ++x){
+        for(unsigned c = 0; c < channels; ++c){
+            const float* table = (c < srgbChannels) ? t.srgbToLinear : t.byteToFloat;
+            dest[x*channels + c] = table[src[x*channels + c]];
+        }
+    }
+}
+
+static void RowFromLinear(const float* src, unsigned char* dest, unsigned width, unsigned channels, unsigned srgbChannels) {
+    const ColorTables& t = Tables();
+    for(unsigned x = 0; x < width; ++x){
+        for(unsigned c = 0; c < channels; ++c){
+            float v = std::min(std::max(src[x*channels + c], 0.0f), 1.0f);
+            if(c < srgbChannels)
+                dest[x*channels + c] = t.linearToSRGB[(unsigned)(v * 65535.0f + 0.5f)];
+            else
+                dest[x*channels + c] = (unsigned char)(v * 255.0f + 0.5f);
+        }
+    }
+}
+
+
+/*
+ * Filter kernels
+ *
+ * Kernels take a distance measured in destination pixels, so the same kernel
+ * works for any scale factor.
+ */
+
+static double BesselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for(int k = 1; k < 32; ++k){
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if(term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+static double Sinc(double x) {
+    if(std::fabs(x) < 1e-8) return 1.0;
+    const double pi = 3.14159265358979323846;
+    return std::sin(pi * x) / (pi * x);
+}
+
+static double FilterRadius(Bitmap::Filter filter) {
+    switch(filter){
+        case Bitmap::Filter_Box: return 0.5;
+        case Bitmap::Filter_Kaiser: return 3.0;
+        case Bitmap::Filter_Bilinear: return 1.0;
+        case Bitmap::Filter_Lanczos: return 3.0;
+        default: throw std::runtime_error("Unrecognised Bitmap::Filter");
+    }
+}
+
+static double FilterWeight(Bitmap::Filter filter, double t) {
+    t = std::fabs(t);
+    switch(filter){
+        case Bitmap::Filter_Box:
+            return (t < 0.5) ? 1.0 : (t == 0.5 ? 0.5 : 0.0);
+        case Bitmap::Filter_Kaiser: {
+            const double radius = 3.0, alpha = 4.0;
+            if(t >= radius) return 0.0;
+            double r = t / radius;
+            return Sinc(t) * BesselI0(alpha * std::sqrt(1.0 - r*r)) / BesselI0(alpha);
+        }
+        case Bitmap::Filter_Bilinear:
+            return (t < 1.0) ? 1.0 - t : 0.0;
+        case Bitmap::Filter_Lanczos:
+            return (t < 3.0) ? Sinc(t) * Sinc(t / 3.0) : 0.0;
+        default:
+            throw std::runtime_error("Unrecognised Bitmap::Filter");
+    }
+}
+
+namespace {
+    /*
+     The source pixels and weights that make up each destination pixel along one axis.
+     Destination pixel i is the weighted sum of source pixels
+     first[i] .. first[i] + tapCount - 1, using weights[i*tapCount ...].
+     */
+    struct FilterTaps {
+        unsigned tapCount;
+        std::vector<unsigned> first;
+        std::vector<float> weights;
+
+        FilterTaps(Bitmap::Filter filter, unsigned srcSize, unsigned destSize) {
+            double scale = (double)srcSize / destSize;
+            double support = FilterRadius(filter) * std::max(scale, 1.0);
+            double kernelScale = std::max(scale, 1.0);
+
+            tapCount = (unsigned)std::ceil(support * 2.0) + 1;
+            first.resize(destSize);
+            weights.assign((size_t)destSize * tapCount, 0.0f);
+
+            for(unsigned i = 0; i < destSize; ++i){
+                double center = (i + 0.5) * scale;
+                int lo = std::max(0, (int)std::ceil(center - support - 0.5));
+                int hi = std::min((int)srcSize - 1, (int)std::floor(center + support - 0.5));
+                lo = std::min(lo, (int)srcSize - 1);
+                hi = std::max(std::min(hi, lo + (int)tapCount - 1), lo);
+                first[i] = (unsigned)lo;
+
+                //weights of the taps that fall outside the image are dropped, and the rest renormalised
+                float* w = &weights[(size_t)i * tapCount];
+                double total = 0.0;
+                for(int s = lo; s <= hi; ++s){
+                    double weight = FilterWeight(filter, (s + 0.5 - center) / kernelScale);
+                    w[s - lo] = (float)weight;
+                    total += weight;
+                }
+                if(std::fabs(total) < 1e-12){
+                    //can happen when the filter is narrower than the pixel spacing
+                    int nearest = std::min(std::max((int)center, lo), hi);
+                    std::fill(w, w + tapCount, 0.0f);
+                    w[nearest - lo] = 1.0f;
+                } else {
+                    for(int s = lo; s <= hi; ++s)
+                        w[s - lo] = (float)(w[s - lo] / total);
+                }
+            }
+        }
+
+        // the last source pixel this destination pixel can read, plus one
+        unsigned end(unsigned i, unsigned srcSize) const {
+            return std::min(first[i] + tapCount, srcSize);
+        }
+    };
+
+    /*
+     Caches the linear float versions of recently used source rows. Destination rows
+     are produced in order, so the source rows they need only ever move forward.
+     */
+    class LinearRowCache {
+    public:
+        LinearRowCache(const Bitmap& src, unsigned srgbChannels, unsigned rowCount) :
+            _src(src),
+            _srgbChannels(srgbChannels),
+            _rowSize((size_t)src.width() * src.format()),
+            _rows((size_t)rowCount * _rowSize),
+            _tags(rowCount, ~0u)
+        {
+        }
+
+        // rows stay valid until `tapCount` newer rows have been requested
+        const float* row(unsigned rowIdx) {
+            unsigned slot = rowIdx % (unsigned)_tags.size();
+            float* dest = &_rows[slot * _rowSize];
+            if(_tags[slot] != rowIdx){
+                RowToLinear(_src.pixelBuffer() + rowIdx * _rowSize, dest, _src.width(), _src.format(), _srgbChannels);
+                _tags[slot] = rowIdx;
+            }
+            return dest;
+        }
+
+    private:
+        const Bitmap& _src;
+        unsigned _srgbChannels;
+        size_t _rowSize;
+        std::vector<float> _rows;
+        std::vector<unsigned> _tags;
+    };
+}
+
+template <unsigned Channels>
+static void HorizontalPass(const float* src, float* dest, unsigned srcWidth, unsigned destWidth, const FilterTaps& taps) {
+    for(unsigned x = 0; x < destWidth; ++x){
+        const float* w = &taps.weights[(size_t)x * taps.tapCount];
+        const float* s = src + taps.first[x] * Channels;
+        unsigned n = taps.end(x, srcWidth) - taps.first[x];
+        float acc[Channels] = {};
+        for(unsigned j = 0; j < n; ++j)
+            for(unsigned c = 0; c < Channels; ++c)
+                acc[c] += w[j] * s[j*Channels + c];
+        for(unsigned c = 0; c < Channels; ++c)
+            dest[x*Channels + c] = acc[c];
+    }
+}
+
+#if defined(TDOGL_BITMAP_SSE2)
+// four channels fill exactly one SSE register, so each tap is a single multiply-add
+template <>
+void HorizontalPass<4>(const float* src, float* dest, unsigned srcWidth, unsigned destWidth, const FilterTaps& taps) {
+    for(unsigned x = 0; x < destWidth; ++x){
+        const float* w = &taps.weights[(size_t)x * taps.tapCount];
+        const float* s = src + taps.first[x] * 4;
+        unsigned n = taps.end(x, srcWidth) - taps.first[x];
+        __m128 acc = _mm_setzero_ps();
+        for(unsigned j = 0; j < n; ++j)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[j]), _mm_loadu_ps(s + j*4)));
+        _mm_storeu_ps(dest + x*4, acc);
+    }
+}
+#endif
+
+#if defined(TDOGL_BITMAP_SSE2)
+// three channels are loaded and stored as four, so each tap is still a single multiply-add.
+// This reads and writes one float past each pixel, which is why the row buffers are padded.
+template <>
+void HorizontalPass<3>(const float* src, float* dest, unsigned srcWidth, unsigned destWidth, const FilterTaps& taps) {
+    for(unsigned x = 0; x < destWidth; ++x){
+        const float* w = &taps.weights[(size_t)x * taps.tapCount];
+        const float* s = src + taps.first[x] * 3;
+        unsigned n = taps.end(x, srcWidth) - taps.first[x];
+        __m128 acc = _mm_setzero_ps();
+        for(unsigned j = 0; j < n; ++j)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[j]), _mm_loadu_ps(s + j*3)));
+        _mm_storeu_ps(dest + x*3, acc); //the fourth float is overwritten by the next pixel
+    }
+}
+#endif
+
+static void HorizontalPass(unsigned channels, const float* src, float* dest, unsigned srcWidth, unsigned destWidth, const FilterTaps& taps) {
+    switch(channels){
+        case 1: HorizontalPass<1>(src, dest, srcWidth, destWidth, taps); break;
+        case 2: HorizontalPass<2>(src, dest, srcWidth, destWidth, taps); break;
+        case 3: HorizontalPass<3>(src, dest, srcWidth, destWidth, taps); break;
+        case 4: HorizontalPass<4>(src, dest, srcWidth, destWidth, taps); break;
+        default: throw std::runtime_error("Invalid bitmap format");
+    }
+}
+
+/*
+ Sums `rowCount` rows of `count` floats, each multiplied by its weight, into `dest`.
+ Each group of four floats is summed in a register across all the rows, so `dest`
+ is only written once no matter how many taps there are.
+ */
+static void VerticalPass(const float* const* rows, const float* weights, unsigned rowCount, float* dest, size_t count) {
+    size_t i = 0;
+#if defined(TDOGL_BITMAP_SSE2)
+    for(; i + 4 <= count; i += 4){
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+        for(unsigned r = 1; r < rowCount; ++r)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[r]), _mm_loadu_ps(rows[r] + i)));
+        _mm_storeu_ps(dest + i, acc);
+    }
+#elif defined(TDOGL_BITMAP_NEON)
+    for(; i + 4 <= count; i += 4){
+        float32x4_t acc = vmulq_n_f32(vld1q_f32(rows[0] + i), weights[0]);
+        for(unsigned r = 1; r < rowCount; ++r)
+            acc = vmlaq_n_f32(acc, vld1q_f32(rows[r] + i), weights[r]);
+        vst1q_f32(dest + i, acc);
+    }
+#endif
+    for(; i < count; ++i){
+        float acc = weights[0] * rows[0][i];
+        for(unsigned r = 1; r < rowCount; ++r)
+            acc += weights[r] * rows[r][i];
+        dest[i] = acc;
+    }
+}
+
+/*
+ Filters rows [firstRow, endRow) of `dest` from `src`. Each destination row is made by
+ summing the source rows it covers (vertical pass), then filtering that single row
+ horizontally, so memory use is a handful of rows no matter how big the image is.
+ */
+static void ResampleRows(const Bitmap& src, Bitmap& dest, const FilterTaps& hTaps, const FilterTaps& vTaps,
+                         unsigned srgbChannels, unsigned firstRow, unsigned endRow)
+{
+    const unsigned channels = src.format();
+    const size_t srcRowSize = (size_t)src.width() * channels;
+    const size_t destRowSize = (size_t)dest.width() * channels;
+
+    LinearRowCache cache(src, srgbChannels, vTaps.tapCount);
+    std::vector<const float*> rows(vTaps.tapCount);
+    //one float of padding for HorizontalPass<3>
+    std::vector<float> column(srcRowSize + 1);
+    std::vector<float> row(destRowSize + 1);
+
+    for(unsigned y = firstRow; y < endRow; ++y){
+        unsigned start = vTaps.first[y];
+        unsigned end = vTaps.end(y, src.height());
+        for(unsigned sy = start; sy < end; ++sy)
+            rows[sy - start] = cache.row(sy);
+
+        VerticalPass(&rows[0], &vTaps.weights[(size_t)y * vTaps.tapCount], end - start, &column[0], srcRowSize);
+        HorizontalPass(channels, &column[0], &row[0], src.width(), dest.width(), hTaps);
+        RowFromLinear(&row[0], dest.pixelBuffer() + y * destRowSize, dest.width(), channels, srgbChannels);
+    }
+}
+
+
+/*
+ * Bitmap methods
+ */
+
+void Bitmap::_resampleInto(Bitmap& dest, Filter filter, bool srgb) const {
+    if(dest._format != _format)
+        throw std::runtime_error("Can't resample into a bitmap with a different format");
+
+    FilterTaps hTaps(filter, _width, dest._width);
+    FilterTaps vTaps(filter, _height, dest._height);
+    unsigned srgbChannels = SRGBChannelCount(_format, srgb);
+    if((size_t)dest._width * dest._height < kMinParallelPixels || WorkerThreadCount() == 1){
+        ResampleRows(*this, dest, hTaps, vTaps, srgbChannels, 0, dest._height);
+    } else {
+        //each band converts the source rows it needs itself, so neighbouring bands
+        //convert a few of the same rows. Two bands per thread evens out the work.
+        unsigned bandCount = std::max(1u, std::min(WorkerThreadCount() * 2, dest._height / kMinRowsPerBand));
+        unsigned rowsPerBand = (dest._height + bandCount - 1) / bandCount;
+        ParallelFor(bandCount, [&](unsigned band){
+            unsigned rowBegin = band * rowsPerBand;
+            ResampleRows(*this, dest, hTaps, vTaps, srgbChannels, rowBegin, std::min(dest._height, rowBegin + rowsPerBand));
+        });
+    }
+}
+
+Bitmap Bitmap::mipmap(Filter filter, bool srgb) const {
+    Bitmap level(std::max(1u, _width / 2), std::max(1u, _height / 2), _format);
+    _resampleInto(level, filter, srgb);
+    return level;
+}
+
+Bitmap Bitmap::resized(unsigned width, unsigned height, Filter filter, bool srgb) const {
+    if(width == 0 || height == 0)
+        throw std::runtime_error("Can't resize a bitmap to zero width or height");
+    Bitmap result(width, height, _format);
+    _resampleInto(result, filter, srgb);
+    return result;
+}
+
+bool Bitmap::shrinkToFit(unsigned maxDimension, size_t maxBytes, Filter filter, bool srgb) {
+    double scale = 1.0;
+    if(maxDimension > 0)
+        scale = std::min(scale, (double)maxDimension / std::max(_width, _height));
+    if(maxBytes > 0)
+        scale = std::min(scale, std::sqrt((double)maxBytes / ((double)_width * _height * _format)));
+    if(scale >= 1.0)
+        return false;
+
+    unsigned width = std::max(1u, (unsigned)(_width * scale));
+    unsigned height = std::max(1u, (unsigned)(_height * scale));
+    //rounding can still leave it a pixel over the byte limit
+    while(maxBytes > 0 && (size_t)width * height * _format > maxBytes && (width > 1 || height > 1)){
+        if(width >= height) --width; else --height;
+    }
+
+    *this = resized(width, height, filter, srgb);
+    return true;
+}
+
+std::vector<Bitmap> Bitmap::mipmaps(Filter filter, bool srgb) const {
+    std::vector<Bitmap> levels;
+    const Bitmap* previous = this;
+    while(previous->width() > 1 || previous->height() > 1){
+        //each level is made from the one before it, which is much cheaper than going back to level 0
+        levels.push_back(previous->mipmap(filter, srgb));
+        previous = &levels.back();
+    }
+    return levels;
+}
@@ -0,0 +1,752 @@
+/*
+ tdogl::CompressedBitmap
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "CompressedBitmap.h"
+#include "Parallel.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace tdogl;
+
+// 16 RGBA pixels of a 4x4 block, in row order
+typedef unsigned char BlockPixels[16][4];
+
+
+/*
+ * Shared helpers
+ */
+
+inline int Clamp255(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+inline int SquaredError(const unsigned char* a, const unsigned char* b, unsigned channels) {
+    int err = 0;
+    for(unsigned c = 0; c < channels; ++c){
+        int d = (int)a[c] - (int)b[c];
+        err += d*d;
+    }
+    return err;
+}
+
+/*
+ Finds the line through the block pixels that best fits them, using the first `channels`
+ channels. Outputs the two ends of the line, clamped to the range the pixels cover.
+ */
+static void PrincipalEndpoints(const BlockPixels px, unsigned channels, float end0[4], float end1[4]) {
+    float mean[4] = {0, 0, 0, 0};
+    for(unsigned i = 0; i < 16; ++i)
+        for(unsigned c = 0; c < channels; ++c)
+            mean[c] += px[i][c];
+    for(unsigned c = 0; c < channels; ++c)
+        mean[c] /= 16.0f;
+
+    float cov[4][4] = {};
+    for(unsigned i = 0; i < 16; ++i){
+        float d[4];
+        for(unsigned c = 0; c < channels; ++c)
+            d[c] = px[i][c] - mean[c];
+        for(unsigned a = 0; a < channels; ++a)
+            for(unsigned b = 0; b < channels; ++b)
+                cov[a][b] += d[a] * d[b];
+    }
+
+    //power iteration for the dominant eigenvector
+    float axis[4] = {1, 1, 1, 1};
+    for(int iter = 0; iter < 8; ++iter){
+        float next[4] = {0, 0, 0, 0};
+        for(unsigned a = 0; a < channels; ++a)
+            for(unsigned b = 0; b < channels; ++b)
+                next[a] += cov[a][b] * axis[b];
+        float len = 0;
+        for(unsigned c = 0; c < channels; ++c)
+            len = std::max(len, std::fabs(next[c]));
+        if(len < 1e-6f)
+            break;
+        for(unsigned c = 0; c < channels; ++c)
+            axis[c] = next[c] / len;
+    }
+
+    float minT = std::numeric_limits<float>::max(), maxT = -minT;
+    for(unsigned i = 0; i < 16; ++i){
+        float t = 0;
+        for(unsigned c = 0; c < channels; ++c)
+            t += (px[i][c] - mean[c]) * axis[c];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+
+    float axisLenSq = 0;
+    for(unsigned c = 0; c < channels; ++c)
+        axisLenSq += axis[c] * axis[c];
+    if(axisLenSq < 1e-12f)
+        axisLenSq = 1;
+
+    for(unsigned c = 0; c < channels; ++c){
+        end0[c] = std::min(std::max(mean[c] + axis[c] * maxT / axisLenSq, 0.0f), 255.0f);
+        end1[c] = std::min(std::max(mean[c] + axis[c] * minT / axisLenSq, 0.0f), 255.0f);
+    }
+}
+
+/*
+ Least squares fit of two endpoints, given the interpolation weight (0 = end0, 1 = end1)
+ picked for every pixel. Returns false if the weights don't constrain both endpoints.
+ */
+static bool FitEndpoints(const BlockPixels px, unsigned channels, const float weights[16], float end0[4], float end1[4]) {
+    float aa = 0, ab = 0, bb = 0;
+    float ax[4] = {0, 0, 0, 0}, bx[4] = {0, 0, 0, 0};
+    for(unsigned i = 0; i < 16; ++i){
+        float b = weights[i], a = 1.0f - b;
+        aa += a*a; ab += a*b; bb += b*b;
+        for(unsigned c = 0; c < channels; ++c){
+            ax[c] += a * px[i][c];
+            bx[c] += b * px[i][c];
+        }
+    }
+    float det = aa*bb - ab*ab;
+    if(std::fabs(det) < 1e-6f)
+        return false;
+    for(unsigned c = 0; c < channels; ++c){
+        end0[c] = std::min(std::max((ax[c]*bb - bx[c]*ab) / det, 0.0f), 255.0f);
+        end1[c] = std::min(std::max((bx[c]*aa - ax[c]*ab) / det, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+// writes bits least significant first, as BC7 blocks are laid out
+class BitWriter {
+public:
+    BitWriter(unsigned char* dest, unsigned size) : _dest(dest), _pos(0) { memset(dest, 0, size); }
+    void write(unsigned value, unsigned bitCount) {
+        for(unsigned i = 0; i < bitCount; ++i, ++_pos)
+            if(value & (1u << i))
+                _dest[_pos / 8] |= (unsigned char)(1u << (_pos % 8));
+    }
+private:
+    unsigned char* _dest;
+    unsigned _pos;
+};
+
+class BitReader {
+public:
+    BitReader(const unsigned char* src) : _src(src), _pos(0) {}
+    unsigned read(unsigned bitCount) {
+        unsigned value = 0;
+        for(unsigned i = 0; i < bitCount; ++i, ++_pos)
+            if(_src[_pos / 8] & (1u << (_pos % 8)))
+                value |= 1u << i;
+        return value;
+    }
+private:
+    const unsigned char* _src;
+    unsigned _pos;
+};
+
+
+/*
+ * BC1 color blocks (also the color half of BC3)
+ */
+
+static unsigned short Pack565(const float c[3]) {
+    unsigned r = (unsigned)(c[0] * 31.0f / 255.0f + 0.5f);
+    unsigned g = (unsigned)(c[1] * 63.0f / 255.0f + 0.5f);
+    unsigned b = (unsigned)(c[2] * 31.0f / 255.0f + 0.5f);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void Unpack565(unsigned short v, unsigned char rgb[3]) {
+    unsigned r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    rgb[0] = (unsigned char)((r << 3) | (r >> 2));
+    rgb[1] = (unsigned char)((g << 2) | (g >> 4));
+    rgb[2] = (unsigned char)((b << 3) | (b >> 2));
+}
+
+// the four colors of a block in four color mode (c0 > c1)
+static void BC1Palette(unsigned short c0, unsigned short c1, unsigned char palette[4][4]) {
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for(unsigned c = 0; c < 3; ++c){
+        palette[2][c] = (unsigned char)((2*palette[0][c] + palette[1][c]) / 3);
+        palette[3][c] = (unsigned char)((palette[0][c] + 2*palette[1][c]) / 3);
+    }
+    for(unsigned i = 0; i < 4; ++i)
+        palette[i][3] = 255;
+}
+
+static int BC1Indices(const BlockPixels px, unsigned short c0, unsigned short c1, unsigned char indices[16]) {
+    unsigned char palette[4][4];
+    BC1Palette(c0, c1, palette);
+    int total = 0;
+    for(unsigned i = 0; i < 16; ++i){
+        int best = std::numeric_limits<int>::max();
+        for(unsigned char p = 0; p < 4; ++p){
+            int err = SquaredError(px[i], palette[p], 3);
+            if(err < best){ best = err; indices[i] = p; }
+        }
+        total += best;
+    }
+    return total;
+}
+
+static void EncodeBC1Block(const BlockPixels px, unsigned char* out) {
+    float end0[4], end1[4];
+    PrincipalEndpoints(px, 3, end0, end1);
+
+    unsigned short bestC0 = Pack565(end0), bestC1 = Pack565(end1);
+    unsigned char bestIndices[16];
+    int bestErr = BC1Indices(px, bestC0, bestC1, bestIndices);
+
+    //refine the endpoints against the chosen indices a couple of times
+    static const float kWeights[4] = {0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f};
+    for(int iter = 0; iter < 2 && bestErr > 0; ++iter){
+        float weights[16];
+        for(unsigned i = 0; i < 16; ++i)
+            weights[i] = kWeights[bestIndices[i]];
+        if(!FitEndpoints(px, 3, weights, end0, end1))
+            break;
+        unsigned short c0 = Pack565(end0), c1 = Pack565(end1);
+        unsigned char indices[16];
+        int err = BC1Indices(px, c0, c1, indices);
+        if(err >= bestErr)
+            break;
+        bestErr = err; bestC0 = c0; bestC1 = c1;
+        memcpy(bestIndices, indices, 16);
+    }
+
+    //four color mode needs c0 > c1. Swapping the endpoints swaps index 0 with 1, and 2 with 3
+    if(bestC0 < bestC1){
+        std::swap(bestC0, bestC1);
+        for(unsigned i = 0; i < 16; ++i)
+            bestIndices[i] ^= 1;
+    } else if(bestC0 == bestC1){
+        memset(bestIndices, 0, 16);
+    }
+
+    unsigned indexBits = 0;
+    for(unsigned i = 0; i < 16; ++i)
+        indexBits |= (unsigned)bestIndices[i] << (2*i);
+
+    out[0] = (unsigned char)(bestC0 & 0xFF); out[1] = (unsigned char)(bestC0 >> 8);
+    out[2] = (unsigned char)(bestC1 & 0xFF); out[3] = (unsigned char)(bestC1 >> 8);
+    for(unsigned i = 0; i < 4; ++i)
+        out[4 + i] = (unsigned char)(indexBits >> (8*i));
+}
+
+static void DecodeBC1Block(const unsigned char* in, BlockPixels px) {
+    unsigned short c0 = (unsigned short)(in[0] | (in[1] << 8));
+    unsigned short c1 = (unsigned short)(in[2] | (in[3] << 8));
+    unsigned char palette[4][4];
+    BC1Palette(c0, c1, palette);
+    if(c0 <= c1){
+        //three color mode, with transparent black as the fourth
+        for(unsigned c = 0; c < 3; ++c){
+            palette[2][c] = (unsigned char)((palette[0][c] + palette[1][c]) / 2);
+            palette[3][c] = 0;
+        }
+        palette[3][3] = 0;
+    }
+    unsigned indexBits = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned)in[7] << 24);
+    for(unsigned i = 0; i < 16; ++i)
+        memcpy(px[i], palette[(indexBits >> (2*i)) & 3], 4);
+}
+
+
+/*
+ * BC4 alpha blocks (the alpha half of BC3)
+ */
+
+static void BC4Palette(unsigned char a0, unsigned char a1, unsigned char palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if(a0 > a1){
+        for(unsigned i = 1; i < 7; ++i)
+            palette[i + 1] = (unsigned char)(((7 - i)*a0 + i*a1) / 7);
+    } else {
+        for(unsigned i = 1; i < 5; ++i)
+            palette[i + 1] = (unsigned char)(((5 - i)*a0 + i*a1) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static void EncodeBC4Block(const BlockPixels px, unsigned channel, unsigned char* out) {
+    unsigned char a0 = 0, a1 = 255;
+    for(unsigned i = 0; i < 16; ++i){
+        a0 = std::max(a0, px[i][channel]);
+        a1 = std::min(a1, px[i][channel]);
+    }
+
+    unsigned char palette[8];
+    BC4Palette(a0, a1, palette);
+
+    unsigned long long indexBits = 0;
+    if(a0 != a1){
+        for(unsigned i = 0; i < 16; ++i){
+            unsigned best = 0;
+            int bestErr = 256;
+            for(unsigned p = 0; p < 8; ++p){
+                int err = std::abs((int)px[i][channel] - (int)palette[p]);
+                if(err < bestErr){ bestErr = err; best = p; }
+            }
+            indexBits |= (unsigned long long)best << (3*i);
+        }
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for(unsigned i = 0; i < 6; ++i)
+        out[2 + i] = (unsigned char)(indexBits >> (8*i));
+}
+
+static void DecodeBC4Block(const unsigned char* in, unsigned channel, BlockPixels px) {
+    unsigned char palette[8];
+    BC4Palette(in[0], in[1], palette);
+    unsigned long long indexBits = 0;
+    for(unsigned i = 0; i < 6; ++i)
+        indexBits |= (unsigned long long)in[2 + i] << (8*i);
+    for(unsigned i = 0; i < 16; ++i)
+        px[i][channel] = palette[(indexBits >> (3*i)) & 7];
+}
+
+
+/*
+ * BC7 blocks
+ *
+ * Only mode 6 is used: a single subset with 7777 RGBA endpoints, one p-bit per
+ * endpoint, and 4 bit indices. It handles alpha well and is simple to search.
+ */
+
+static const int kBC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// quantizes an endpoint to 7 bits per channel plus a shared p-bit
+static void QuantizeBC7Endpoint(const float end[4], unsigned char q[4], unsigned& pbit) {
+    float bestErr = std::numeric_limits<float>::max();
+    for(unsigned p = 0; p < 2; ++p){
+        unsigned char candidate[4];
+        float err = 0;
+        for(unsigned c = 0; c < 4; ++c){
+            int v = (int)std::floor((end[c] - p) / 2.0f + 0.5f);
+            candidate[c] = (unsigned char)std::min(std::max(v, 0), 127);
+            float d = (float)((candidate[c] << 1) | p) - end[c];
+            err += d*d;
+        }
+        if(err < bestErr){
+            bestErr = err;
+            pbit = p;
+            memcpy(q, candidate, 4);
+        }
+    }
+}
+
+static void BC7Palette(const unsigned char q0[4], unsigned p0, const unsigned char q1[4], unsigned p1, unsigned char palette[16][4]) {
+    for(unsigned c = 0; c < 4; ++c){
+        int e0 = (q0[c] << 1) | p0;
+        int e1 = (q1[c] << 1) | p1;
+        for(unsigned i = 0; i < 16; ++i)
+            palette[i][c] = (unsigned char)((e0*(64 - kBC7Weights4[i]) + e1*kBC7Weights4[i] + 32) >> 6);
+    }
+}
+
+static int BC7Indices(const BlockPixels px, const unsigned char palette[16][4], unsigned char indices[16]) {
+    int total = 0;
+    for(unsigned i = 0; i < 16; ++i){
+        int best = std::numeric_limits<int>::max();
+        for(unsigned char p = 0; p < 16; ++p){
+            int err = SquaredError(px[i], palette[p], 4);
+            if(err < best){ best = err; indices[i] = p; }
+        }
+        total += best;
+    }
+    return total;
+}
+
+static void EncodeBC7Block(const BlockPixels px, unsigned char* out) {
+    float end0[4], end1[4];
+    PrincipalEndpoints(px, 4, end0, end1);
+
+    unsigned char bestQ0[4], bestQ1[4], bestIndices[16];
+    unsigned bestP0 = 0, bestP1 = 0;
+    int bestErr = std::numeric_limits<int>::max();
+
+    for(int iter = 0; iter < 3; ++iter){
+        unsigned char q0[4], q1[4], indices[16], palette[16][4];
+        unsigned p0, p1;
+        QuantizeBC7Endpoint(end0, q0, p0);
+        QuantizeBC7Endpoint(end1, q1, p1);
+        BC7Palette(q0, p0, q1, p1, palette);
+        int err = BC7Indices(px, palette, indices);
+        if(err >= bestErr)
+            break;
+        bestErr = err;
+        memcpy(bestQ0, q0, 4); memcpy(bestQ1, q1, 4); memcpy(bestIndices, indices, 16);
+        bestP0 = p0; bestP1 = p1;
+        if(err == 0)
+            break;
+
+        float weights[16];
+        for(unsigned i = 0; i < 16; ++i)
+            weights[i] = kBC7Weights4[indices[i]] / 64.0f;
+        if(!FitEndpoints(px, 4, weights, end0, end1))
+            break;
+    }
+
+    //the first pixel's index is stored with its top bit implied to be zero
+    if(bestIndices[0] & 8){
+        unsigned char tmp[4];
+        memcpy(tmp, bestQ0, 4); memcpy(bestQ0, bestQ1, 4); memcpy(bestQ1, tmp, 4);
+        std::swap(bestP0, bestP1);
+        for(unsigned i = 0; i < 16; ++i)
+            bestIndices[i] = (unsigned char)(15 - bestIndices[i]);
+    }
+
+    BitWriter bits(out, 16);
+    bits.write(1 << 6, 7); //mode 6
+    for(unsigned c = 0; c < 4; ++c){
+        bits.write(bestQ0[c], 7);
+        bits.write(bestQ1[c], 7);
+    }
+    bits.write(bestP0, 1);
+    bits.write(bestP1, 1);
+    bits.write(bestIndices[0], 3);
+    for(unsigned i = 1; i < 16; ++i)
+        bits.write(bestIndices[i], 4);
+}
+
+static void DecodeBC7Block(const unsigned char* in, BlockPixels px) {
+    BitReader bits(in);
+    if(bits.read(7) != (1 << 6))
+        throw std::runtime_error("Only BC7 mode 6 blocks can be decompressed");
+
+    unsigned char q0[4], q1[4];
+    for(unsigned c = 0; c < 4; ++c){
+        q0[c] = (unsigned char)bits.read(7);
+        q1[c] = (unsigned char)bits.read(7);
+    }
+    unsigned p0 = bits.read(1);
+    unsigned p1 = bits.read(1);
+
+    unsigned char palette[16][4];
+    BC7Palette(q0, p0, q1, p1, palette);
+    for(unsigned i = 0; i < 16; ++i)
+        memcpy(px[i], palette[bits.read(i == 0 ? 3 : 4)], 4);
+}
+
+
+/*
+ * ETC2 RGB blocks
+ *
+ * Only the individual and differential modes are used, which makes every block a
+ * valid ETC1 block too. The differential mode is only chosen when the second base
+ * color stays in range, because ETC2 decoders treat overflow as the T, H and
+ * planar modes.
+ */
+
+static const int kETCModifiers[8][4] = {
+    {2, 8, -2, -8}, {5, 17, -5, -17}, {9, 29, -9, -29}, {13, 42, -13, -42},
+    {18, 60, -18, -60}, {24, 80, -24, -80}, {33, 106, -33, -106}, {47, 183, -47, -183}
+};
+
+inline bool ETCInSubblock(unsigned x, unsigned y, bool flip, unsigned subblock) {
+    return (flip ? (y >= 2) : (x >= 2)) == (subblock == 1);
+}
+
+/*
+ Picks the best modifier table and per-pixel modifiers for one subblock with the given
+ base color. Indices are stored per pixel in row order. Returns the squared error.
+ */
+static int ETCFitSubblock(const BlockPixels px, bool flip, unsigned subblock, const int base[3],
+                          unsigned& table, unsigned char indices[16])
+{
+    int bestTotal = std::numeric_limits<int>::max();
+    for(unsigned t = 0; t < 8; ++t){
+        int total = 0;
+        unsigned char tIndices[16];
+        for(unsigned y = 0; y < 4; ++y){
+            for(unsigned x = 0; x < 4; ++x){
+                if(!ETCInSubblock(x, y, flip, subblock))
+                    continue;
+                const unsigned char* p = px[y*4 + x];
+                int best = std::numeric_limits<int>::max();
+                for(unsigned m = 0; m < 4; ++m){
+                    unsigned char c[3];
+                    for(unsigned k = 0; k < 3; ++k)
+                        c[k] = (unsigned char)Clamp255(base[k] + kETCModifiers[t][m]);
+                    int err = SquaredError(p, c, 3);
+                    if(err < best){ best = err; tIndices[y*4 + x] = (unsigned char)m; }
+                }
+                total += best;
+            }
+        }
+        if(total < bestTotal){
+            bestTotal = total;
+            table = t;
+            for(unsigned i = 0; i < 16; ++i)
+                if(ETCInSubblock(i % 4, i / 4, flip, subblock))
+                    indices[i] = tIndices[i];
+        }
+    }
+    return bestTotal;
+}
+
+static void EncodeETC2Block(const BlockPixels px, unsigned char* out) {
+    unsigned long long bestBits = 0;
+    int bestErr = std::numeric_limits<int>::max();
+
+    for(unsigned flip = 0; flip < 2; ++flip){
+        float avg[2][3] = {};
+        for(unsigned i = 0; i < 16; ++i){
+            unsigned sub = ETCInSubblock(i % 4, i / 4, flip != 0, 1) ? 1 : 0;
+            for(unsigned c = 0; c < 3; ++c)
+                avg[sub][c] += px[i][c] / 8.0f;
+        }
+
+        for(unsigned diff = 0; diff < 2; ++diff){
+            int q[2][3], base[2][3];
+            bool fits = true;
+            for(unsigned s = 0; s < 2; ++s){
+                for(unsigned c = 0; c < 3; ++c){
+                    if(diff){
+                        q[s][c] = (int)(avg[s][c] * 31.0f / 255.0f + 0.5f);
+                        base[s][c] = (q[s][c] << 3) | (q[s][c] >> 2);
+                    } else {
+                        q[s][c] = (int)(avg[s][c] * 15.0f / 255.0f + 0.5f);
+                        base[s][c] = q[s][c] * 17;
+                    }
+                }
+            }
+            for(unsigned c = 0; c < 3 && diff; ++c){
+                int d = q[1][c] - q[0][c];
+                if(d < -4 || d > 3)
+                    fits = false;
+            }
+            if(!fits)
+                continue;
+
+            unsigned tables[2];
+            unsigned char indices[16];
+            int err = ETCFitSubblock(px, flip != 0, 0, base[0], tables[0], indices)
+                    + ETCFitSubblock(px, flip != 0, 1, base[1], tables[1], indices);
+            if(err >= bestErr)
+                continue;
+            bestErr = err;
+
+            unsigned long long bits = 0;
+            for(unsigned c = 0; c < 3; ++c){
+                unsigned shift = 56 - 8*c;
+                if(diff){
+                    bits |= (unsigned long long)q[0][c] << (shift + 3);
+                    bits |= (unsigned long long)((q[1][c] - q[0][c]) & 7) << shift;
+                } else {
+                    bits |= (unsigned long long)q[0][c] << (shift + 4);
+                    bits |= (unsigned long long)q[1][c] << shift;
+                }
+            }
+            bits |= (unsigned long long)tables[0] << 37;
+            bits |= (unsigned long long)tables[1] << 34;
+            bits |= (unsigned long long)diff << 33;
+            bits |= (unsigned long long)flip << 32;
+            for(unsigned i = 0; i < 16; ++i){
+                unsigned bit = (i % 4)*4 + (i / 4); //pixels are numbered down the columns
+                bits |= (unsigned long long)(indices[i] >> 1) << (16 + bit);
+                bits |= (unsigned long long)(indices[i] & 1) << bit;
+            }
+            bestBits = bits;
+        }
+    }
+
+    for(unsigned i = 0; i < 8; ++i)
+        out[i] = (unsigned char)(bestBits >> (56 - 8*i));
+}
+
+static void DecodeETC2Block(const unsigned char* in, BlockPixels px) {
+    unsigned long long bits = 0;
+    for(unsigned i = 0; i < 8; ++i)
+        bits = (bits << 8) | in[i];
+
+    bool diff = ((bits >> 33) & 1) != 0;
+    bool flip = ((bits >> 32) & 1) != 0;
+    unsigned tables[2] = { (unsigned)(bits >> 37) & 7, (unsigned)(bits >> 34) & 7 };
+
+    int base[2][3];
+    for(unsigned c = 0; c < 3; ++c){
+        unsigned shift = 56 - 8*c;
+        if(diff){
+            int q0 = (int)(bits >> (shift + 3)) & 31;
+            int d = (int)(bits >> shift) & 7;
+            int q1 = q0 + (d >= 4 ? d - 8 : d);
+            if(q1 < 0 || q1 > 31)
+                throw std::runtime_error("ETC2 T, H and planar blocks can't be decompressed");
+            base[0][c] = (q0 << 3) | (q0 >> 2);
+            base[1][c] = (q1 << 3) | (q1 >> 2);
+        } else {
+            base[0][c] = (int)((bits >> (shift + 4)) & 15) * 17;
+            base[1][c] = (int)((bits >> shift) & 15) * 17;
+        }
+    }
+
+    for(unsigned i = 0; i < 16; ++i){
+        unsigned x = i % 4, y = i / 4;
+        unsigned bit = x*4 + y;
+        unsigned m = (unsigned)(((bits >> (16 + bit)) & 1) << 1 | ((bits >> bit) & 1));
+        unsigned sub = ETCInSubblock(x, y, flip, 1) ? 1 : 0;
+        for(unsigned c = 0; c < 3; ++c)
+            px[i][c] = (unsigned char)Clamp255(base[sub][c] + kETCModifiers[tables[sub]][m]);
+        px[i][3] = 255;
+    }
+}
+
+
+/*
+ * CompressedBitmap class
+ */
+
+CompressedBitmap::CompressedBitmap(unsigned width, unsigned height, Format format, bool srgb) :
+    _format(format),
+    _width(width),
+    _height(height),
+    _srgb(srgb),
+    _data((size_t)((width + 3) / 4) * ((height + 3) / 4) * bytesPerBlock(format))
+{
+}
+
+unsigned CompressedBitmap::bytesPerBlock(Format format) {
+    switch(format){
+        case Format_BC1: return 8;
+        case Format_BC3: return 16;
+        case Format_BC7: return 16;
+        case Format_ETC2_RGB: return 8;
+        default: throw std::runtime_error("Unrecognised CompressedBitmap::Format");
+    }
+}
+
+CompressedBitmap CompressedBitmap::compress(const Bitmap& bitmap, Format format, bool srgb) {
+    //every encoder works on RGBA blocks
+    const Bitmap* rgba = &bitmap;
+    Bitmap converted(1, 1, Bitmap::Format_RGBA);
+    if(bitmap.format() != Bitmap::Format_RGBA){
+        converted = Bitmap(bitmap.width(), bitmap.height(), Bitmap::Format_RGBA);
+        converted.copyRectFromBitmap(bitmap, 0, 0, 0, 0, 0, 0);
+        rgba = &converted;
+    }
+
+    CompressedBitmap result(bitmap.width(), bitmap.height(), format, srgb);
+    const unsigned blocksWide = (bitmap.width() + 3) / 4;
+    const unsigned blocksHigh = (bitmap.height() + 3) / 4;
+    const unsigned blockSize = bytesPerBlock(format);
+
+    ParallelFor(blocksHigh, [&](unsigned by){
+        BlockPixels px;
+        for(unsigned bx = 0; bx < blocksWide; ++bx){
+            for(unsigned y = 0; y < 4; ++y){
+                for(unsigned x = 0; x < 4; ++x){
+                    unsigned col = std::min(bx*4 + x, rgba->width() - 1);
+                    unsigned row = std::min(by*4 + y, rgba->height() - 1);
+                    memcpy(px[y*4 + x], rgba->pixelBuffer() + ((size_t)row * rgba->width() + col) * 4, 4);
+                }
+            }
+
+            unsigned char* out = &result._data[((size_t)by * blocksWide + bx) * blockSize];
+            switch(format){
+                case Format_BC1: EncodeBC1Block(px, out); break;
+                case Format_BC3: EncodeBC4Block(px, 3, out); EncodeBC1Block(px, out + 8); break;
+                case Format_BC7: EncodeBC7Block(px, out); break;
+                case Format_ETC2_RGB: EncodeETC2Block(px, out); break;
+            }
+        }
+    });
+
+    return result;
+}
+
+Bitmap CompressedBitmap::decompress() const {
+    bool hasAlpha = (_format == Format_BC3 || _format == Format_BC7);
+    Bitmap::Format outFormat = hasAlpha ? Bitmap::Format_RGBA : Bitmap::Format_RGB;
+    Bitmap result(_width, _height, outFormat);
+
+    const unsigned blocksWide = (_width + 3) / 4;
+    const unsigned blocksHigh = (_height + 3) / 4;
+    const unsigned blockSize = bytesPerBlock(_format);
+
+    for(unsigned by = 0; by < blocksHigh; ++by){
+        for(unsigned bx = 0; bx < blocksWide; ++bx){
+            const unsigned char* in = &_data[((size_t)by * blocksWide + bx) * blockSize];
+            BlockPixels px;
+            switch(_format){
+                case Format_BC1: DecodeBC1Block(in, px); break;
+                case Format_BC3: DecodeBC1Block(in + 8, px); DecodeBC4Block(in, 3, px); break;
+                case Format_BC7: DecodeBC7Block(in, px); break;
+                case Format_ETC2_RGB: DecodeETC2Block(in, px); break;
+            }
+
+            for(unsigned y = 0; y < 4 && by*4 + y < _height; ++y)
+                for(unsigned x = 0; x < 4 && bx*4 + x < _width; ++x)
+                    result.setPixel(bx*4 + x, by*4 + y, px[y*4 + x]);
+        }
+    }
+
+    return result;
+}
+
+double CompressedBitmap::psnr(const Bitmap& a, const Bitmap& b) {
+    if(a.width() != b.width() || a.height() != b.height())
+        throw std::runtime_error("Can't compare bitmaps of different sizes");
+
+    Bitmap rgbaA(a.width(), a.height(), Bitmap::Format_RGBA);
+    Bitmap rgbaB(b.width(), b.height(), Bitmap::Format_RGBA);
+    rgbaA.copyRectFromBitmap(a, 0, 0, 0, 0, 0, 0);
+    rgbaB.copyRectFromBitmap(b, 0, 0, 0, 0, 0, 0);
+
+    size_t count = (size_t)a.width() * a.height() * 4;
+    double sum = 0;
+    for(size_t i = 0; i < count; ++i){
+        double d = (double)rgbaA.pixelBuffer()[i] - (double)rgbaB.pixelBuffer()[i];
+        sum += d*d;
+    }
+    if(sum == 0)
+        return std::numeric_limits<double>::infinity();
+
+    double mse = sum / count;
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+unsigned CompressedBitmap::width() const {
+    return _width;
+}
+
+unsigned CompressedBitmap::height() const {
+    return _height;
+}
+
+CompressedBitmap::Format CompressedBitmap::format() const {
+    return _format;
+}
+
+bool CompressedBitmap::isSRGB() const {
+    return _srgb;
+}
+
+const unsigned char* CompressedBitmap::data() const {
+    return _data.empty() ? NULL : &_data[0];
+}
+
+size_t CompressedBitmap::dataSize() const {
+    return _data.size();
+}
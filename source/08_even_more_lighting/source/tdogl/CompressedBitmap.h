@@ -0,0 +1,110 @@
+/*
+ tdogl::CompressedBitmap
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Bitmap.h"
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A bitmap image stored in a block compressed format that GPUs can sample directly.
+
+     The image is split into 4x4 pixel blocks, and each block is stored in a fixed
+     number of bytes. Images with a width or height that isn't a multiple of 4 are
+     padded out to whole blocks by repeating the edge pixels.
+
+     Can be used to make OpenGL textures using tdogl::Texture, which stay compressed
+     in video memory.
+     */
+    class CompressedBitmap {
+    public:
+        /**
+         The block compression format.
+         */
+        enum Format {
+            Format_BC1, /**< RGB in 8 bytes per block, a.k.a. DXT1. Alpha is discarded */
+            Format_BC3, /**< RGBA in 16 bytes per block, a.k.a. DXT5 */
+            Format_BC7, /**< RGBA in 16 bytes per block. Best quality, but needs GL 4.2 or ARB_texture_compression_bptc */
+            Format_ETC2_RGB /**< RGB in 8 bytes per block. Needs GL 4.3 or ARB_ES3_compatibility. Alpha is discarded */
+        };
+
+        /**
+         Compresses a bitmap, using all the worker threads (see tdogl::ParallelFor).
+
+         Bitmaps of any format are accepted. Grayscale is compressed as RGB.
+
+         @param bitmap  The bitmap to compress
+         @param format  The format to compress into
+         @param srgb  Whether the color channels are sRGB encoded. This doesn't change the
+                      compressed data, only which internal format tdogl::Texture uploads it as.
+         */
+        static CompressedBitmap compress(const Bitmap& bitmap, Format format, bool srgb = true);
+
+        /**
+         Decompresses back into a tdogl::Bitmap, so the result of compression can be
+         inspected on the CPU.
+
+         The result is Format_RGBA for BC3 and BC7, and Format_RGB otherwise. Only the
+         block modes that `compress` produces can be decompressed.
+         */
+        Bitmap decompress() const;
+
+        /**
+         Peak signal-to-noise ratio between two bitmaps of the same size, in decibels.
+         Higher is better, and identical bitmaps give infinity. Bitmaps of different
+         formats are compared as RGBA.
+         */
+        static double psnr(const Bitmap& a, const Bitmap& b);
+
+        /** The number of bytes each 4x4 block takes in the given format */
+        static unsigned bytesPerBlock(Format format);
+
+        /** width in pixels */
+        unsigned width() const;
+
+        /** height in pixels */
+        unsigned height() const;
+
+        /** the compression format */
+        Format format() const;
+
+        /** whether the color channels are sRGB encoded */
+        bool isSRGB() const;
+
+        /**
+         The compressed blocks, ordered left to right, then top to bottom, ready to pass
+         to glCompressedTexImage2D.
+         */
+        const unsigned char* data() const;
+
+        /** size of `data()` in bytes */
+        size_t dataSize() const;
+
+    private:
+        Format _format;
+        unsigned _width;
+        unsigned _height;
+        bool _srgb;
+        std::vector<unsigned char> _data;
+
+        CompressedBitmap(unsigned width, unsigned height, Format format, bool srgb);
+    };
+
+}
@@ -0,0 +1,136 @@
+/*
+ tdogl::DynamicTexture
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "DynamicTexture.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace tdogl;
+
+//past this many separate rectangles, they are all merged into one
+static const size_t kMaxDirtyRects = 16;
+
+static size_t Area(unsigned minCol, unsigned minRow, unsigned maxCol, unsigned maxRow) {
+    return (size_t)(maxCol - minCol) * (size_t)(maxRow - minRow);
+}
+
+DynamicTexture::DynamicTexture(const Bitmap& bitmap, GLint minMagFiler, GLint wrapMode) :
+    _bitmap(bitmap),
+    _texture(bitmap, minMagFiler, wrapMode)
+{
+}
+
+const Texture& DynamicTexture::texture() const {
+    return _texture;
+}
+
+const Bitmap& DynamicTexture::bitmap() const {
+    return _bitmap;
+}
+
+void DynamicTexture::setPixel(unsigned column, unsigned row, const unsigned char* pixel) {
+    _bitmap.setPixel(column, row, pixel);
+    markDirty(column, row, 1, 1);
+}
+
+void DynamicTexture::copyRectFromBitmap(const Bitmap& src,
+                                        unsigned srcCol,
+                                        unsigned srcRow,
+                                        unsigned destCol,
+                                        unsigned destRow,
+                                        unsigned width,
+                                        unsigned height)
+{
+    _bitmap.copyRectFromBitmap(src, srcCol, srcRow, destCol, destRow, width, height);
+    if(srcCol == 0 && srcRow == 0 && width == 0 && height == 0){
+        width = src.width();
+        height = src.height();
+    }
+    markDirty(destCol, destRow, width, height);
+}
+
+void DynamicTexture::setRows(unsigned firstRow, unsigned rowCount, const unsigned char* pixels) {
+    if(firstRow > _bitmap.height() || rowCount > _bitmap.height() - firstRow)
+        throw std::runtime_error("Rows don't fit within the bitmap");
+
+    size_t rowSize = (size_t)_bitmap.width() * _bitmap.format();
+    std::memcpy(_bitmap.getPixel(0, firstRow), pixels, rowSize * rowCount);
+    markDirty(0, firstRow, _bitmap.width(), rowCount);
+}
+
+BitmapView DynamicTexture::edit(unsigned col, unsigned row, unsigned width, unsigned height) {
+    BitmapView view = _bitmap.view(col, row, width, height);
+    markDirty(col, row, width, height);
+    return view;
+}
+
+void DynamicTexture::markDirty(unsigned col, unsigned row, unsigned width, unsigned height) {
+    Rect rect;
+    rect.minCol = std::min(col, _bitmap.width());
+    rect.minRow = std::min(row, _bitmap.height());
+    rect.maxCol = std::min(rect.minCol + std::min(width, _bitmap.width()), _bitmap.width());
+    rect.maxRow = std::min(rect.minRow + std::min(height, _bitmap.height()), _bitmap.height());
+    if(rect.minCol == rect.maxCol || rect.minRow == rect.maxRow)
+        return;
+
+    //merge with any rect where the union wastes less than a quarter of the two areas
+    for(size_t i = 0; i < _dirty.size(); ){
+        const Rect& other = _dirty[i];
+        Rect merged;
+        merged.minCol = std::min(rect.minCol, other.minCol);
+        merged.minRow = std::min(rect.minRow, other.minRow);
+        merged.maxCol = std::max(rect.maxCol, other.maxCol);
+        merged.maxRow = std::max(rect.maxRow, other.maxRow);
+
+        size_t separate = Area(rect.minCol, rect.minRow, rect.maxCol, rect.maxRow) +
+                          Area(other.minCol, other.minRow, other.maxCol, other.maxRow);
+        if(Area(merged.minCol, merged.minRow, merged.maxCol, merged.maxRow) * 4 <= separate * 5){
+            rect = merged;
+            _dirty.erase(_dirty.begin() + i);
+            //the bigger rect may now merge with ones that were checked already
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+
+    if(_dirty.size() == kMaxDirtyRects){
+        for(size_t i = 0; i < _dirty.size(); ++i){
+            rect.minCol = std::min(rect.minCol, _dirty[i].minCol);
+            rect.minRow = std::min(rect.minRow, _dirty[i].minRow);
+            rect.maxCol = std::max(rect.maxCol, _dirty[i].maxCol);
+            rect.maxRow = std::max(rect.maxRow, _dirty[i].maxRow);
+        }
+        _dirty.clear();
+    }
+    _dirty.push_back(rect);
+}
+
+size_t DynamicTexture::flush() {
+    size_t bytes = 0;
+    for(size_t i = 0; i < _dirty.size(); ++i){
+        const Rect& rect = _dirty[i];
+        BitmapView view = _bitmap.view(rect.minCol, rect.minRow, rect.maxCol - rect.minCol, rect.maxRow - rect.minRow);
+        //update sets GL_UNPACK_ROW_LENGTH, so the rows are read straight out of the bitmap
+        _texture.update(view, (GLint)rect.minCol, (GLint)rect.minRow);
+        bytes += (size_t)view.width() * view.height() * view.format();
+    }
+    _dirty.clear();
+    return bytes;
+}
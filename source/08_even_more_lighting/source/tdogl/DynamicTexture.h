@@ -0,0 +1,125 @@
+/*
+ tdogl::DynamicTexture
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+#pragma once
+
+#include "Bitmap.h"
+#include "Texture.h"
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A texture that changes a little at a time, e.g. painted decals or a status
+     overlay.
+
+     Keeps a tdogl::Bitmap copy of the texture's pixels. Edits are made to the
+     bitmap through the methods below, which remember which rectangles changed.
+     `flush` uploads just those rectangles with glTexSubImage2D, straight out of
+     the bitmap, instead of uploading the whole texture again.
+
+     Nearby dirty rectangles are merged when the merged rectangle isn't much bigger
+     than the two separately, so setting a line of pixels one at a time is uploaded
+     as a single rectangle.
+
+     Example:
+
+         DynamicTexture overlay(Bitmap(256, 256, Bitmap::Format_RGBA));
+         overlay.copyRectFromBitmap(icon, 0, 0, 32, 32, icon.width(), icon.height());
+         overlay.setPixel(10, 10, red);
+         overlay.flush();
+         glBindTexture(GL_TEXTURE_2D, overlay.texture().object());
+     */
+    class DynamicTexture {
+    public:
+        /**
+         Creates the texture from a bitmap, which is copied.
+
+         @param bitmap  The initial pixels
+         @param minMagFiler  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         */
+        DynamicTexture(const Bitmap& bitmap,
+                       GLint minMagFiler = GL_LINEAR,
+                       GLint wrapMode = GL_CLAMP_TO_EDGE);
+
+        /** The texture. Only up to date after `flush`. */
+        const Texture& texture() const;
+
+        /** The current pixels, including changes that haven't been flushed yet */
+        const Bitmap& bitmap() const;
+
+        /** Same as tdogl::Bitmap::setPixel */
+        void setPixel(unsigned column, unsigned row, const unsigned char* pixel);
+
+        /** Same as tdogl::Bitmap::copyRectFromBitmap */
+        void copyRectFromBitmap(const Bitmap& src,
+                                unsigned srcCol,
+                                unsigned srcRow,
+                                unsigned destCol,
+                                unsigned destRow,
+                                unsigned width,
+                                unsigned height);
+
+        /**
+         Replaces whole rows of pixels.
+
+         @param firstRow  The first row to replace
+         @param rowCount  How many rows to replace
+         @param pixels  The new rows, tightly packed, in the same format as the bitmap
+         */
+        void setRows(unsigned firstRow, unsigned rowCount, const unsigned char* pixels);
+
+        /**
+         A view of a rectangle of the bitmap for making any other kind of change.
+         The whole rectangle is marked dirty, so make the changes before the next
+         `flush`.
+         */
+        BitmapView edit(unsigned col, unsigned row, unsigned width, unsigned height);
+
+        /**
+         Marks a rectangle as dirty, for changes made to the bitmap some other way.
+         The rectangle is clipped to the bitmap.
+         */
+        void markDirty(unsigned col, unsigned row, unsigned width, unsigned height);
+
+        /**
+         Uploads the dirty rectangles into the texture. Call this once per frame,
+         before drawing with the texture.
+
+         @result The number of bytes of pixel data uploaded
+         */
+        size_t flush();
+
+    private:
+        struct Rect {
+            unsigned minCol;
+            unsigned minRow;
+            unsigned maxCol; //exclusive
+            unsigned maxRow; //exclusive
+        };
+
+        Bitmap _bitmap;
+        Texture _texture;
+        std::vector<Rect> _dirty;
+
+        //copying disabled
+        DynamicTexture(const DynamicTexture&);
+        const DynamicTexture& operator=(const DynamicTexture&);
+    };
+
+}
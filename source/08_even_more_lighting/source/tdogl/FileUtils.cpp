@@ -0,0 +1,87 @@
+/*
+ tdogl file helpers
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "FileUtils.h"
+#include <stdexcept>
+
+#if defined(_WIN32)
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+using namespace tdogl;
+
+static std::string TempPath(const std::string& filePath) {
+    return filePath + ".tmp";
+}
+
+std::vector<unsigned char> tdogl::ReadFileContents(const std::string& filePath) {
+    FILE* f = fopen(filePath.c_str(), "rb");
+    if(!f)
+        throw std::runtime_error(std::string("Failed to open file: ") + filePath);
+    
+    std::vector<unsigned char> contents;
+    unsigned char buffer[64 * 1024];
+    size_t count;
+    while((count = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        contents.insert(contents.end(), buffer, buffer + count);
+    
+    bool failed = (ferror(f) != 0);
+    fclose(f);
+    if(failed)
+        throw std::runtime_error(std::string("Failed to read file: ") + filePath);
+    return contents;
+}
+
+unsigned long long tdogl::HashBytes(const void* bytes, size_t size, unsigned long long hash) {
+    const unsigned char* b = (const unsigned char*)bytes;
+    for(size_t i = 0; i < size; ++i){
+        hash ^= b[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void tdogl::MakeDirectory(const std::string& directory) {
+    //fails harmlessly if the directory already exists
+#if defined(_WIN32)
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+FILE* tdogl::CreateTempFile(const std::string& filePath) {
+    return fopen(TempPath(filePath).c_str(), "wb");
+}
+
+bool tdogl::FinishTempFile(FILE* file, const std::string& filePath, bool ok) {
+    std::string tempPath = TempPath(filePath);
+    ok = (fclose(file) == 0) && ok;
+    if(ok){
+#if defined(_WIN32)
+        //rename doesn't replace existing files on Windows
+        remove(filePath.c_str());
+#endif
+        ok = (rename(tempPath.c_str(), filePath.c_str()) == 0);
+    }
+    if(!ok)
+        remove(tempPath.c_str());
+    return ok;
+}
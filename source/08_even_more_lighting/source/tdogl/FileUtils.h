@@ -0,0 +1,65 @@
+/*
+ tdogl file helpers
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace tdogl {
+    
+    /**
+     Reads a whole file into memory.
+     
+     @throws std::exception if the file can't be opened or read
+     */
+    std::vector<unsigned char> ReadFileContents(const std::string& filePath);
+    
+    /**
+     Hashes bytes with 64 bit FNV-1a. Not for security, just for naming cache files.
+     
+     @param hash  The result of a previous call, to hash more bytes onto the end
+     */
+    unsigned long long HashBytes(const void* bytes, size_t size, unsigned long long hash = 14695981039346656037ULL);
+    
+    /**
+     Creates a directory. Does nothing if it already exists, or can't be created.
+     */
+    void MakeDirectory(const std::string& directory);
+    
+    /**
+     Opens a temporary file next to `filePath` for writing. Once it's written, call
+     FinishTempFile to move it over `filePath`, so a half written file never
+     replaces a good one, even if the app crashes.
+     
+     @result The open file, or NULL if it couldn't be created
+     */
+    FILE* CreateTempFile(const std::string& filePath);
+    
+    /**
+     Closes a file from CreateTempFile. If `ok` is true and the file closes
+     cleanly, it replaces `filePath`. Otherwise it is deleted.
+     
+     @param ok  false if writing the file failed
+     @result true if `filePath` was replaced
+     */
+    bool FinishTempFile(FILE* file, const std::string& filePath, bool ok);
+    
+}
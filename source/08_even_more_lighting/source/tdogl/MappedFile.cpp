@@ -0,0 +1,106 @@
+/*
+ tdogl::MappedFile
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "MappedFile.h"
+#include <stdexcept>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace tdogl;
+
+MappedFile::MappedFile(const std::string& filePath) :
+    _mapping(NULL),
+    _size(0)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(std::string("Failed to open file: ") + filePath);
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+        CloseHandle(file);
+        throw std::runtime_error(std::string("Empty file: ") + filePath);
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(!mapping)
+        throw std::runtime_error(std::string("Failed to map file: ") + filePath);
+
+    _mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); //the view keeps the mapping alive
+    if(!_mapping)
+        throw std::runtime_error(std::string("Failed to map file: ") + filePath);
+    _size = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error(std::string("Failed to open file: ") + filePath);
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0){
+        close(fd);
+        throw std::runtime_error(std::string("Empty file: ") + filePath);
+    }
+
+    void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //the mapping stays valid after the file is closed
+    if(mapped == MAP_FAILED)
+        throw std::runtime_error(std::string("Failed to map file: ") + filePath);
+    _mapping = mapped;
+    _size = (size_t)info.st_size;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    UnmapViewOfFile(_mapping);
+#else
+    munmap(_mapping, _size);
+#endif
+}
+
+const unsigned char* MappedFile::bytes() const {
+    return (const unsigned char*)_mapping;
+}
+
+size_t MappedFile::size() const {
+    return _size;
+}
+
+void MappedFile::willNeed(size_t offset, size_t size) const {
+    if(offset >= _size || size == 0)
+        return;
+    if(size > _size - offset)
+        size = _size - offset;
+
+#if !defined(_WIN32)
+    //madvise wants a page aligned address
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset / pageSize * pageSize;
+    madvise((char*)_mapping + start, size + (offset - start), MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,67 @@
+/*
+ tdogl::MappedFile
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace tdogl {
+
+    /**
+     A read-only memory mapping of a whole file.
+
+     Pages of the file are only read from disk when they are first touched, so
+     mapping a huge file is cheap, and the OS can drop pages again when memory
+     gets low.
+     */
+    class MappedFile {
+    public:
+        /**
+         Maps the given file.
+
+         @throws std::exception if the file can't be opened, is empty, or can't be mapped
+         */
+        explicit MappedFile(const std::string& filePath);
+
+        /** Unmaps the file, which invalidates all pointers into it */
+        ~MappedFile();
+
+        /** the first byte of the file */
+        const unsigned char* bytes() const;
+
+        /** size of the file in bytes */
+        size_t size() const;
+
+        /**
+         Hints that the given byte range will be read soon, so the OS can start
+         reading it from disk in the background. Does nothing on platforms that
+         don't support it.
+         */
+        void willNeed(size_t offset, size_t size) const;
+
+    private:
+        void* _mapping;
+        size_t _size;
+
+        //copying disabled
+        MappedFile(const MappedFile&);
+        const MappedFile& operator=(const MappedFile&);
+    };
+
+}
@@ -0,0 +1,150 @@
+/*
+ tdogl::ParallelFor
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace tdogl;
+
+namespace {
+    //one call to ParallelFor
+    struct Job {
+        const std::function<void(unsigned)>* func;
+        unsigned count;
+        std::atomic<unsigned> nextIndex;
+        unsigned workerCount; //pool threads working on this job. Guarded by the pool mutex.
+        std::exception_ptr firstError;
+        std::mutex errorMutex;
+    };
+    
+    class WorkerPool {
+    public:
+        explicit WorkerPool(unsigned threadCount);
+        void run(Job& job);
+        
+    private:
+        std::mutex _mutex;
+        std::condition_variable _workAvailable;
+        std::condition_variable _jobFinished;
+        std::deque<Job*> _jobs;
+        std::vector<std::thread> _threads;
+        
+        void _threadMain();
+    };
+}
+
+//true on pool threads, and on any thread while it is running a ParallelFor
+static thread_local bool gInsideParallelFor = false;
+
+static void DoWork(Job& job) {
+    for(;;){
+        unsigned i = job.nextIndex++;
+        if(i >= job.count)
+            break;
+        
+        try {
+            (*job.func)(i);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(job.errorMutex);
+            if(!job.firstError)
+                job.firstError = std::current_exception();
+            job.nextIndex = job.count; //stop handing out work
+        }
+    }
+}
+
+WorkerPool::WorkerPool(unsigned threadCount) {
+    for(unsigned t = 0; t < threadCount; ++t)
+        _threads.push_back(std::thread(&WorkerPool::_threadMain, this));
+}
+
+void WorkerPool::run(Job& job) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(&job);
+    }
+    _workAvailable.notify_all();
+    
+    DoWork(job);
+    
+    //every index has been handed out, so stop more threads from joining in, then
+    //wait for the ones still working on their last index
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::deque<Job*>::iterator found = std::find(_jobs.begin(), _jobs.end(), &job);
+    if(found != _jobs.end())
+        _jobs.erase(found);
+    _jobFinished.wait(lock, [&](){ return job.workerCount == 0; });
+}
+
+void WorkerPool::_threadMain() {
+    gInsideParallelFor = true;
+    
+    std::unique_lock<std::mutex> lock(_mutex);
+    for(;;){
+        _workAvailable.wait(lock, [&](){ return !_jobs.empty(); });
+        Job* job = _jobs.front();
+        ++job->workerCount;
+        
+        lock.unlock();
+        DoWork(*job);
+        lock.lock();
+        
+        //the job has no indices left, so nobody else needs to pick it up
+        if(!_jobs.empty() && _jobs.front() == job)
+            _jobs.pop_front();
+        if(--job->workerCount == 0)
+            _jobFinished.notify_all();
+    }
+}
+
+unsigned tdogl::WorkerThreadCount() {
+    //hardware_concurrency is allowed to return 0 if it can't tell
+    static const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    return count;
+}
+
+void tdogl::ParallelFor(unsigned count, const std::function<void(unsigned)>& func) {
+    if(count <= 1 || WorkerThreadCount() <= 1 || gInsideParallelFor){
+        for(unsigned i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+    
+    //never deleted, so it still works if ParallelFor is called during static destruction
+    static WorkerPool* pool = new WorkerPool(WorkerThreadCount() - 1);
+    
+    Job job;
+    job.func = &func;
+    job.count = count;
+    job.nextIndex = 0;
+    job.workerCount = 0;
+    
+    gInsideParallelFor = true;
+    pool->run(job);
+    gInsideParallelFor = false;
+    
+    if(job.firstError)
+        std::rethrow_exception(job.firstError);
+}
@@ -0,0 +1,50 @@
+/*
+ tdogl::ParallelFor
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+
+namespace tdogl {
+    
+    /**
+     @result The number of worker threads used by tdogl::ParallelFor. This is the
+             number of hardware threads on the machine, and is always at least 1.
+     */
+    unsigned WorkerThreadCount();
+    
+    /**
+     Calls `func` once for every index from 0 to `count - 1`, spreading the calls
+     over WorkerThreadCount() threads. The calling thread is one of the workers,
+     and the rest come from a pool that is started on first use and reused after
+     that, so no threads are made per call.
+     
+     Indices are handed out one at a time, so it doesn't matter if some calls
+     take much longer than others. Returns once every call has finished.
+     
+     A ParallelFor inside `func` runs on the thread that called it, because every
+     worker is already busy with the outer loop. This keeps nested loops (e.g. a
+     batch of images that are each flipped with ParallelFor) from oversubscribing
+     the machine.
+     
+     @throws Rethrows the first exception thrown by `func`. Indices that haven't
+             started yet when that happens are skipped.
+     */
+    void ParallelFor(unsigned count, const std::function<void(unsigned)>& func);
+    
+}
@@ -0,0 +1,203 @@
+/*
+ tdogl::PixelAllocator
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "PixelAllocator.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+using namespace tdogl;
+
+//size classes go from 320 bytes up to 256MB, four per power of two
+static const unsigned kSizeClassCount = 80;
+static const unsigned kUnpooled = (unsigned)-1;
+
+//every block starts with a header, padded out so the pixels stay aligned
+struct BlockHeader {
+    unsigned sizeClass;
+    size_t capacity;
+    size_t size;
+};
+static const size_t kHeaderSize = PixelAlignment;
+
+static std::atomic<PixelAllocator*> gCurrentAllocator(NULL);
+
+static size_t SizeClassCapacity(unsigned sizeClass) {
+    return (size_t)(5 + sizeClass % 4) << (6 + sizeClass / 4);
+}
+
+static unsigned SizeClassForSize(size_t size) {
+    if(size <= SizeClassCapacity(0))
+        return 0;
+    if(size > SizeClassCapacity(kSizeClassCount - 1))
+        return kUnpooled;
+    
+    //the top three bits of (size - 1) pick the class
+    size_t v = size - 1;
+    unsigned msb = 0;
+    while((v >> msb) > 1)
+        ++msb;
+    unsigned shift = msb - 2;
+    return (shift - 6) * 4 + (unsigned)((v >> shift) - 4);
+}
+
+static void* AlignedAlloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, PixelAlignment);
+#else
+    void* ptr = NULL;
+    if(posix_memalign(&ptr, PixelAlignment, size) != 0)
+        return NULL;
+    return ptr;
+#endif
+}
+
+static void AlignedFree(void* ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+static BlockHeader* HeaderForBlock(void* ptr) {
+    return (BlockHeader*)((unsigned char*)ptr - kHeaderSize);
+}
+
+
+/*
+ * PixelAllocator class
+ */
+
+PixelAllocator& PixelAllocator::current() {
+    PixelAllocator* allocator = gCurrentAllocator.load(std::memory_order_acquire);
+    return allocator ? *allocator : PooledPixelAllocator::shared();
+}
+
+void PixelAllocator::setCurrent(PixelAllocator* allocator) {
+    gCurrentAllocator.store(allocator, std::memory_order_release);
+}
+
+
+/*
+ * PooledPixelAllocator class
+ */
+
+PooledPixelAllocator::PooledPixelAllocator(size_t maxCachedBytes) :
+    _maxCachedBytes(maxCachedBytes),
+    _freeBlocks(kSizeClassCount)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+PooledPixelAllocator::~PooledPixelAllocator() {
+    trim();
+}
+
+void* PooledPixelAllocator::allocate(size_t size) {
+    unsigned sizeClass = SizeClassForSize(size);
+    size_t capacity = (sizeClass == kUnpooled) ? size : SizeClassCapacity(sizeClass);
+    
+    void* block = NULL;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.allocations += 1;
+        _stats.bytesInUse += capacity;
+        if(sizeClass != kUnpooled && !_freeBlocks[sizeClass].empty()){
+            block = _freeBlocks[sizeClass].back();
+            _freeBlocks[sizeClass].pop_back();
+            _stats.bytesCached -= capacity;
+            _stats.poolHits += 1;
+        }
+    }
+    
+    if(!block){
+        block = AlignedAlloc(kHeaderSize + capacity);
+        if(!block){
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.bytesInUse -= capacity;
+            return NULL;
+        }
+    }
+    
+    BlockHeader* header = (BlockHeader*)block;
+    header->sizeClass = sizeClass;
+    header->capacity = capacity;
+    header->size = size;
+    return (unsigned char*)block + kHeaderSize;
+}
+
+void* PooledPixelAllocator::reallocate(void* ptr, size_t size) {
+    if(!ptr)
+        return allocate(size);
+    
+    BlockHeader* header = HeaderForBlock(ptr);
+    if(size <= header->capacity){
+        //still fits in the same size class
+        header->size = size;
+        return ptr;
+    }
+    
+    void* newPtr = allocate(size);
+    if(!newPtr)
+        return NULL;
+    memcpy(newPtr, ptr, header->size);
+    deallocate(ptr);
+    return newPtr;
+}
+
+void PooledPixelAllocator::deallocate(void* ptr) {
+    if(!ptr)
+        return;
+    
+    BlockHeader* header = HeaderForBlock(ptr);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.bytesInUse -= header->capacity;
+        if(header->sizeClass != kUnpooled && _stats.bytesCached + header->capacity <= _maxCachedBytes){
+            _freeBlocks[header->sizeClass].push_back(header);
+            _stats.bytesCached += header->capacity;
+            return;
+        }
+    }
+    AlignedFree(header);
+}
+
+void PooledPixelAllocator::trim() {
+    std::vector< std::vector<void*> > freeBlocks(kSizeClassCount);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        freeBlocks.swap(_freeBlocks);
+        _stats.bytesCached = 0;
+    }
+    
+    for(size_t i = 0; i < freeBlocks.size(); ++i){
+        for(size_t j = 0; j < freeBlocks[i].size(); ++j)
+            AlignedFree(freeBlocks[i][j]);
+    }
+}
+
+PooledPixelAllocator::Stats PooledPixelAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+PooledPixelAllocator& PooledPixelAllocator::shared() {
+    static PooledPixelAllocator* pool = new PooledPixelAllocator();
+    return *pool;
+}
@@ -0,0 +1,129 @@
+/*
+ tdogl::PixelAllocator
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace tdogl {
+    
+    /** The alignment in bytes of every block returned by a tdogl::PixelAllocator */
+    const size_t PixelAlignment = 64;
+    
+    /**
+     Allocates the pixel buffers of tdogl::Bitmap, and all the memory that
+     stb_image uses while decoding image files.
+     
+     Every block must be aligned to PixelAlignment bytes, so the first row of
+     every bitmap starts on a cache line.
+     */
+    class PixelAllocator {
+    public:
+        virtual ~PixelAllocator() {}
+        
+        /** Allocates at least `size` bytes. Returns NULL if out of memory. */
+        virtual void* allocate(size_t size) = 0;
+        
+        /**
+         Same as realloc. `ptr` can be NULL, and the contents are kept up to the
+         smaller of the old and new sizes. Returns NULL if out of memory, in which
+         case `ptr` is still valid.
+         */
+        virtual void* reallocate(void* ptr, size_t size) = 0;
+        
+        /** Frees a block returned from `allocate` or `reallocate`. `ptr` can be NULL. */
+        virtual void deallocate(void* ptr) = 0;
+        
+        /**
+         @result The allocator that bitmaps currently use. This is
+                 PooledPixelAllocator::shared() unless `setCurrent` was called.
+         */
+        static PixelAllocator& current();
+        
+        /**
+         Replaces the allocator that bitmaps use.
+         
+         Must be called before any bitmaps are made, because blocks are always
+         freed by the current allocator. The allocator must outlive every bitmap.
+         
+         @param allocator  The new allocator, or NULL to go back to the shared pool
+         */
+        static void setCurrent(PixelAllocator* allocator);
+    };
+    
+    /**
+     The default tdogl::PixelAllocator. It rounds sizes up to a set of size
+     classes, no more than 25% apart, and keeps freed blocks in a list per size
+     class to be reused by later allocations of the same class.
+     
+     Loading lots of images in a row then mostly reuses the same few blocks,
+     instead of fragmenting the heap with allocations of every possible size.
+     Blocks over 256MB are not pooled. All methods are thread safe.
+     */
+    class PooledPixelAllocator : public PixelAllocator {
+    public:
+        /**
+         Usage statistics, in bytes and numbers of calls
+         */
+        struct Stats {
+            size_t bytesInUse; /**< Size classes of all blocks currently allocated */
+            size_t bytesCached; /**< Size classes of all free blocks waiting to be reused */
+            size_t allocations; /**< Total number of allocations */
+            size_t poolHits; /**< Number of allocations that reused a free block */
+        };
+        
+        /**
+         @param maxCachedBytes  The most memory to hold on to in free blocks. Freed
+                                blocks that would go over this are released.
+         */
+        explicit PooledPixelAllocator(size_t maxCachedBytes = 256*1024*1024);
+        
+        /** Releases all free blocks. Blocks still in use are leaked. */
+        ~PooledPixelAllocator();
+        
+        void* allocate(size_t size);
+        void* reallocate(void* ptr, size_t size);
+        void deallocate(void* ptr);
+        
+        /** Releases all the free blocks */
+        void trim();
+        
+        /** @result The current usage statistics */
+        Stats stats() const;
+        
+        /**
+         The allocator used when no other one has been set with
+         PixelAllocator::setCurrent. It is never destroyed, so that bitmaps in
+         global variables can still be freed at exit.
+         */
+        static PooledPixelAllocator& shared();
+        
+    private:
+        size_t _maxCachedBytes;
+        mutable std::mutex _mutex;
+        std::vector< std::vector<void*> > _freeBlocks;
+        Stats _stats;
+        
+        //copying disabled
+        PooledPixelAllocator(const PooledPixelAllocator&);
+        const PooledPixelAllocator& operator=(const PooledPixelAllocator&);
+    };
+    
+}
@@ -0,0 +1,179 @@
+/*
+ tdogl::PixelView
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Bitmap.h"
+#include <stdexcept>
+
+namespace tdogl {
+    
+    /**
+     The layout of one pixel of the given tdogl::Bitmap::Format. Each struct is
+     exactly as many bytes as the format has channels, so a row of pixels can be
+     treated as an array of them.
+     */
+    template<Bitmap::Format F> struct Pixel;
+    
+    template<> struct Pixel<Bitmap::Format_Grayscale> { unsigned char gray; };
+    template<> struct Pixel<Bitmap::Format_GrayscaleAlpha> { unsigned char gray, alpha; };
+    template<> struct Pixel<Bitmap::Format_RGB> { unsigned char r, g, b; };
+    template<> struct Pixel<Bitmap::Format_RGBA> { unsigned char r, g, b, a; };
+    
+    typedef Pixel<Bitmap::Format_Grayscale> Gray8;
+    typedef Pixel<Bitmap::Format_GrayscaleAlpha> GrayAlpha8;
+    typedef Pixel<Bitmap::Format_RGB> RGB8;
+    typedef Pixel<Bitmap::Format_RGBA> RGBA8;
+    
+    static_assert(sizeof(Gray8) == 1 && sizeof(GrayAlpha8) == 2 && sizeof(RGB8) == 3 && sizeof(RGBA8) == 4,
+                  "Pixel structs must not be padded");
+    
+    /**
+     A tdogl::BitmapView where the format is known at compile time, so that rows
+     can be accessed as arrays of Pixel structs.
+     
+     The format is checked once, when the view is made. Nothing else is checked,
+     so row and column indices must be in bounds.
+     */
+    template<Bitmap::Format F>
+    class TypedBitmapView {
+    public:
+        typedef Pixel<F> PixelType;
+        
+        /** @throws std::exception if `view` isn't in format F */
+        explicit TypedBitmapView(const BitmapView& view) :
+            _view(view)
+        {
+            if(view.format() != F)
+                throw std::runtime_error("Bitmap view has the wrong format");
+        }
+        
+        /** width in pixels */
+        unsigned width() const { return _view.width(); }
+        
+        /** height in pixels */
+        unsigned height() const { return _view.height(); }
+        
+        /** the untyped view */
+        const BitmapView& view() const { return _view; }
+        
+        /** the pixels of the given row, from left to right */
+        PixelType* row(unsigned y) const { return (PixelType*)_view.rowPointer(y); }
+        
+        /** the pixel at the given coordinates */
+        PixelType& operator()(unsigned x, unsigned y) const { return row(y)[x]; }
+        
+    private:
+        BitmapView _view;
+    };
+    
+    /**
+     Calls `func(pixels, count)` for every row of the view, where `pixels` is a
+     `Pixel<F>*`. Contiguous views are passed as a single row of all the pixels,
+     which gives the compiler the longest possible loop to vectorize.
+     */
+    template<Bitmap::Format F, typename Func>
+    void ForEachRow(const BitmapView& view, Func func) {
+        TypedBitmapView<F> typed(view);
+        if(view.isContiguous()){
+            func(typed.row(0), (size_t)view.width() * view.height());
+        } else {
+            for(unsigned y = 0; y < view.height(); ++y)
+                func(typed.row(y), (size_t)view.width());
+        }
+    }
+    
+    /**
+     Calls `func(pixel)` on every pixel of the view, where `pixel` is a `Pixel<F>&`
+     that can be modified.
+     
+     e.g. premultiplying alpha:
+     
+         ForEachPixel<Bitmap::Format_RGBA>(bitmap, [](RGBA8& p){
+             p.r = (unsigned char)((p.r * p.a + 127) / 255);
+             p.g = (unsigned char)((p.g * p.a + 127) / 255);
+             p.b = (unsigned char)((p.b * p.a + 127) / 255);
+         });
+     
+     @throws std::exception if `view` isn't in format F
+     */
+    template<Bitmap::Format F, typename Func>
+    void ForEachPixel(const BitmapView& view, Func func) {
+        ForEachRow<F>(view, [&](Pixel<F>* pixels, size_t count){
+            for(size_t i = 0; i < count; ++i)
+                func(pixels[i]);
+        });
+    }
+    
+    /**
+     Same as the other `ForEachPixel`, except the format is checked at runtime and
+     `func` is called with the Pixel struct of whatever format the view is. `func`
+     must accept all four, e.g. a lambda with an `auto&` parameter or a struct with
+     four `operator()` overloads.
+     */
+    template<typename Func>
+    void ForEachPixel(const BitmapView& view, Func func) {
+        switch(view.format()){
+            case Bitmap::Format_Grayscale: ForEachPixel<Bitmap::Format_Grayscale>(view, func); break;
+            case Bitmap::Format_GrayscaleAlpha: ForEachPixel<Bitmap::Format_GrayscaleAlpha>(view, func); break;
+            case Bitmap::Format_RGB: ForEachPixel<Bitmap::Format_RGB>(view, func); break;
+            case Bitmap::Format_RGBA: ForEachPixel<Bitmap::Format_RGBA>(view, func); break;
+            default: throw std::runtime_error("Unhandled bitmap format");
+        }
+    }
+    
+    /**
+     Sets every pixel of `dest` to `func(srcPixel)`, where `srcPixel` is the
+     `const Pixel<SrcF>&` at the same coordinates in `src`, and `func` returns a
+     `Pixel<DestF>`.
+     
+     e.g. making a luminance mask from an RGB bitmap:
+     
+         TransformPixels<Bitmap::Format_RGB, Bitmap::Format_Grayscale>(rgb, mask, [](const RGB8& p){
+             Gray8 result = { (unsigned char)((p.r * 54 + p.g * 183 + p.b * 19) >> 8) };
+             return result;
+         });
+     
+     `src` and `dest` can be the same memory if the formats are the same.
+     
+     @throws std::exception if the views are different sizes or the formats are wrong
+     */
+    template<Bitmap::Format SrcF, Bitmap::Format DestF, typename Func>
+    void TransformPixels(const BitmapView& src, const BitmapView& dest, Func func) {
+        if(src.width() != dest.width() || src.height() != dest.height())
+            throw std::runtime_error("Can't transform between bitmap views of different sizes");
+        
+        TypedBitmapView<SrcF> typedSrc(src);
+        TypedBitmapView<DestF> typedDest(dest);
+        if(src.isContiguous() && dest.isContiguous()){
+            const Pixel<SrcF>* s = typedSrc.row(0);
+            Pixel<DestF>* d = typedDest.row(0);
+            size_t count = (size_t)src.width() * src.height();
+            for(size_t i = 0; i < count; ++i)
+                d[i] = func(s[i]);
+        } else {
+            for(unsigned y = 0; y < src.height(); ++y){
+                const Pixel<SrcF>* s = typedSrc.row(y);
+                Pixel<DestF>* d = typedDest.row(y);
+                for(unsigned x = 0; x < src.width(); ++x)
+                    d[x] = func(s[x]);
+            }
+        }
+    }
+    
+}
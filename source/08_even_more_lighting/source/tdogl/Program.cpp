@@ -17,11 +17,20 @@
  */
 
 #include "Program.h"
+#include <map>
 #include <stdexcept>
 #include <glm/gtc/type_ptr.hpp>
 
 using namespace tdogl;
 
+// set with Program::setUniformBlockBinding
+static std::map<std::string, GLuint> gUniformBlockBindings;
+
+Program::Program() :
+    _object(0)
+{
+}
+
 Program::Program(const std::vector<Shader>& shaders) :
     _object(0)
 {
@@ -33,6 +42,10 @@ Program::Program(const std::vector<Shader>& shaders) :
     if(_object == 0)
         throw std::runtime_error("glCreateProgram failed");
     
+    //ask the driver to keep the binary around, in case it's saved with `binary`
+    if(binariesSupported())
+        glProgramParameteri(_object, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    
     //attach all the shaders
     for(unsigned i = 0; i < shaders.size(); ++i)
         glAttachShader(_object, shaders[i].object());
@@ -44,22 +57,28 @@ Program::Program(const std::vector<Shader>& shaders) :
     for(unsigned i = 0; i < shaders.size(); ++i)
         glDetachShader(_object, shaders[i].object());
     
-    //throw exception if linking failed
-    GLint status;
-    glGetProgramiv(_object, GL_LINK_STATUS, &status);
-    if (status == GL_FALSE) {
-        std::string msg("Program linking failure: ");
-        
-        GLint infoLogLength;
-        glGetProgramiv(_object, GL_INFO_LOG_LENGTH, &infoLogLength);
-        char* strInfoLog = new char[infoLogLength + 1];
-        glGetProgramInfoLog(_object, infoLogLength, NULL, strInfoLog);
-        msg += strInfoLog;
-        delete[] strInfoLog;
+    _checkLinkStatus();
+    _linked();
+}
+
+Program* Program::programFromBinary(GLenum binaryFormat, const void* binary, GLsizei size) {
+    if(!binariesSupported())
+        throw std::runtime_error("Program binaries are not supported");
+    
+    Program* program = new Program();
+    try {
+        program->_object = glCreateProgram();
+        if(program->_object == 0)
+            throw std::runtime_error("glCreateProgram failed");
         
-        glDeleteProgram(_object); _object = 0;
-        throw std::runtime_error(msg);
+        glProgramBinary(program->_object, binaryFormat, binary, size);
+        program->_checkLinkStatus();
+        program->_linked();
+    } catch(...) {
+        delete program;
+        throw;
     }
+    return program;
 }
 
 Program::~Program() {
@@ -67,6 +86,33 @@ Program::~Program() {
     if(_object != 0) glDeleteProgram(_object);
 }
 
+std::vector<unsigned char> Program::binary(GLenum& binaryFormat) const {
+    binaryFormat = 0;
+    std::vector<unsigned char> result;
+    if(!binariesSupported())
+        return result;
+    
+    GLint length = 0;
+    glGetProgramiv(_object, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return result;
+    
+    result.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(_object, length, &written, &binaryFormat, &result[0]);
+    result.resize(written);
+    return result;
+}
+
+bool Program::binariesSupported() {
+    if(!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+        return false;
+    
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
 GLuint Program::object() const {
     return _object;
 }
@@ -90,7 +136,7 @@ GLint Program::attrib(const GLchar* attribName) const {
     if(!attribName)
         throw std::runtime_error("attribName was NULL");
     
-    GLint attrib = glGetAttribLocation(_object, attribName);
+    GLint attrib = _findLocation(_attribs, attribName);
     if(attrib == -1)
         throw std::runtime_error(std::string("Program attribute not found: ") + attribName);
     
@@ -101,84 +147,190 @@ GLint Program::uniform(const GLchar* uniformName) const {
     if(!uniformName)
         throw std::runtime_error("uniformName was NULL");
     
-    GLint uniform = glGetUniformLocation(_object, uniformName);
+    GLint uniform = _findLocation(_uniforms, uniformName);
     if(uniform == -1)
         throw std::runtime_error(std::string("Program uniform not found: ") + uniformName);
     
     return uniform;
 }
 
+GLint Program::uniform(UniformName uniformName) const {
+    GLint uniform = _findLocation(_uniforms, uniformName);
+    if(uniform == -1)
+        throw std::runtime_error(std::string("Program uniform not found: ") + uniformName.name());
+    
+    return uniform;
+}
+
+void Program::bindUniformBlock(const GLchar* blockName, GLuint bindingPoint) {
+    if(!blockName)
+        throw std::runtime_error("blockName was NULL");
+    
+    GLuint blockIndex = glGetUniformBlockIndex(_object, blockName);
+    if(blockIndex == GL_INVALID_INDEX)
+        throw std::runtime_error(std::string("Program uniform block not found: ") + blockName);
+    
+    glUniformBlockBinding(_object, blockIndex, bindingPoint);
+}
+
+void Program::setUniformBlockBinding(const std::string& blockName, GLuint bindingPoint) {
+    gUniformBlockBindings[blockName] = bindingPoint;
+}
+
 #define ATTRIB_N_UNIFORM_SETTERS(OGL_TYPE, TYPE_PREFIX, TYPE_SUFFIX) \
+\
+    void Program::setAttrib(GLint location, OGL_TYPE v0) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 1 ## TYPE_SUFFIX (location, v0); } \
+    void Program::setAttrib(GLint location, OGL_TYPE v0, OGL_TYPE v1) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 2 ## TYPE_SUFFIX (location, v0, v1); } \
+    void Program::setAttrib(GLint location, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 3 ## TYPE_SUFFIX (location, v0, v1, v2); } \
+    void Program::setAttrib(GLint location, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 4 ## TYPE_SUFFIX (location, v0, v1, v2, v3); } \
+\
+    void Program::setAttrib1v(GLint location, const OGL_TYPE* v) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 1 ## TYPE_SUFFIX ## v (location, v); } \
+    void Program::setAttrib2v(GLint location, const OGL_TYPE* v) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 2 ## TYPE_SUFFIX ## v (location, v); } \
+    void Program::setAttrib3v(GLint location, const OGL_TYPE* v) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 3 ## TYPE_SUFFIX ## v (location, v); } \
+    void Program::setAttrib4v(GLint location, const OGL_TYPE* v) \
+        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 4 ## TYPE_SUFFIX ## v (location, v); } \
+\
+    void Program::setUniform(GLint location, OGL_TYPE v0) \
+        { assert(isInUse()); glUniform1 ## TYPE_SUFFIX (location, v0); } \
+    void Program::setUniform(GLint location, OGL_TYPE v0, OGL_TYPE v1) \
+        { assert(isInUse()); glUniform2 ## TYPE_SUFFIX (location, v0, v1); } \
+    void Program::setUniform(GLint location, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2) \
+        { assert(isInUse()); glUniform3 ## TYPE_SUFFIX (location, v0, v1, v2); } \
+    void Program::setUniform(GLint location, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3) \
+        { assert(isInUse()); glUniform4 ## TYPE_SUFFIX (location, v0, v1, v2, v3); } \
+\
+    void Program::setUniform1v(GLint location, const OGL_TYPE* v, GLsizei count) \
+        { assert(isInUse()); glUniform1 ## TYPE_SUFFIX ## v (location, count, v); } \
+    void Program::setUniform2v(GLint location, const OGL_TYPE* v, GLsizei count) \
+        { assert(isInUse()); glUniform2 ## TYPE_SUFFIX ## v (location, count, v); } \
+    void Program::setUniform3v(GLint location, const OGL_TYPE* v, GLsizei count) \
+        { assert(isInUse()); glUniform3 ## TYPE_SUFFIX ## v (location, count, v); } \
+    void Program::setUniform4v(GLint location, const OGL_TYPE* v, GLsizei count) \
+        { assert(isInUse()); glUniform4 ## TYPE_SUFFIX ## v (location, count, v); } \
 \
     void Program::setAttrib(const GLchar* name, OGL_TYPE v0) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 1 ## TYPE_SUFFIX (attrib(name), v0); } \
+        { setAttrib(attrib(name), v0); } \
     void Program::setAttrib(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 2 ## TYPE_SUFFIX (attrib(name), v0, v1); } \
+        { setAttrib(attrib(name), v0, v1); } \
     void Program::setAttrib(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 3 ## TYPE_SUFFIX (attrib(name), v0, v1, v2); } \
+        { setAttrib(attrib(name), v0, v1, v2); } \
     void Program::setAttrib(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 4 ## TYPE_SUFFIX (attrib(name), v0, v1, v2, v3); } \
+        { setAttrib(attrib(name), v0, v1, v2, v3); } \
 \
     void Program::setAttrib1v(const GLchar* name, const OGL_TYPE* v) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 1 ## TYPE_SUFFIX ## v (attrib(name), v); } \
+        { setAttrib1v(attrib(name), v); } \
     void Program::setAttrib2v(const GLchar* name, const OGL_TYPE* v) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 2 ## TYPE_SUFFIX ## v (attrib(name), v); } \
+        { setAttrib2v(attrib(name), v); } \
     void Program::setAttrib3v(const GLchar* name, const OGL_TYPE* v) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 3 ## TYPE_SUFFIX ## v (attrib(name), v); } \
+        { setAttrib3v(attrib(name), v); } \
     void Program::setAttrib4v(const GLchar* name, const OGL_TYPE* v) \
-        { assert(isInUse()); glVertexAttrib ## TYPE_PREFIX ## 4 ## TYPE_SUFFIX ## v (attrib(name), v); } \
+        { setAttrib4v(attrib(name), v); } \
 \
     void Program::setUniform(const GLchar* name, OGL_TYPE v0) \
-        { assert(isInUse()); glUniform1 ## TYPE_SUFFIX (uniform(name), v0); } \
+        { setUniform(uniform(name), v0); } \
     void Program::setUniform(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1) \
-        { assert(isInUse()); glUniform2 ## TYPE_SUFFIX (uniform(name), v0, v1); } \
+        { setUniform(uniform(name), v0, v1); } \
     void Program::setUniform(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2) \
-        { assert(isInUse()); glUniform3 ## TYPE_SUFFIX (uniform(name), v0, v1, v2); } \
+        { setUniform(uniform(name), v0, v1, v2); } \
     void Program::setUniform(const GLchar* name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3) \
-        { assert(isInUse()); glUniform4 ## TYPE_SUFFIX (uniform(name), v0, v1, v2, v3); } \
+        { setUniform(uniform(name), v0, v1, v2, v3); } \
 \
     void Program::setUniform1v(const GLchar* name, const OGL_TYPE* v, GLsizei count) \
-        { assert(isInUse()); glUniform1 ## TYPE_SUFFIX ## v (uniform(name), count, v); } \
+        { setUniform1v(uniform(name), v, count); } \
     void Program::setUniform2v(const GLchar* name, const OGL_TYPE* v, GLsizei count) \
-        { assert(isInUse()); glUniform2 ## TYPE_SUFFIX ## v (uniform(name), count, v); } \
+        { setUniform2v(uniform(name), v, count); } \
     void Program::setUniform3v(const GLchar* name, const OGL_TYPE* v, GLsizei count) \
-        { assert(isInUse()); glUniform3 ## TYPE_SUFFIX ## v (uniform(name), count, v); } \
+        { setUniform3v(uniform(name), v, count); } \
     void Program::setUniform4v(const GLchar* name, const OGL_TYPE* v, GLsizei count) \
-        { assert(isInUse()); glUniform4 ## TYPE_SUFFIX ## v (uniform(name), count, v); }
+        { setUniform4v(uniform(name), v, count); } \
+\
+    void Program::setUniform(UniformName name, OGL_TYPE v0) \
+        { setUniform(uniform(name), v0); } \
+    void Program::setUniform(UniformName name, OGL_TYPE v0, OGL_TYPE v1) \
+        { setUniform(uniform(name), v0, v1); } \
+    void Program::setUniform(UniformName name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2) \
+        { setUniform(uniform(name), v0, v1, v2); } \
+    void Program::setUniform(UniformName name, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3) \
+        { setUniform(uniform(name), v0, v1, v2, v3); } \
+\
+    void Program::setUniform1v(UniformName name, const OGL_TYPE* v, GLsizei count) \
+        { setUniform1v(uniform(name), v, count); } \
+    void Program::setUniform2v(UniformName name, const OGL_TYPE* v, GLsizei count) \
+        { setUniform2v(uniform(name), v, count); } \
+    void Program::setUniform3v(UniformName name, const OGL_TYPE* v, GLsizei count) \
+        { setUniform3v(uniform(name), v, count); } \
+    void Program::setUniform4v(UniformName name, const OGL_TYPE* v, GLsizei count) \
+        { setUniform4v(uniform(name), v, count); }
 
 ATTRIB_N_UNIFORM_SETTERS(GLfloat, , f);
 ATTRIB_N_UNIFORM_SETTERS(GLdouble, , d);
 ATTRIB_N_UNIFORM_SETTERS(GLint, I, i);
 ATTRIB_N_UNIFORM_SETTERS(GLuint, I, ui);
 
-void Program::setUniformMatrix2(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+void Program::setUniformMatrix2(GLint location, const GLfloat* v, GLsizei count, GLboolean transpose) {
     assert(isInUse());
-    glUniformMatrix2fv(uniform(name), count, transpose, v);
+    glUniformMatrix2fv(location, count, transpose, v);
 }
 
-void Program::setUniformMatrix3(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+void Program::setUniformMatrix3(GLint location, const GLfloat* v, GLsizei count, GLboolean transpose) {
     assert(isInUse());
-    glUniformMatrix3fv(uniform(name), count, transpose, v);
+    glUniformMatrix3fv(location, count, transpose, v);
 }
 
-void Program::setUniformMatrix4(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+void Program::setUniformMatrix4(GLint location, const GLfloat* v, GLsizei count, GLboolean transpose) {
     assert(isInUse());
-    glUniformMatrix4fv(uniform(name), count, transpose, v);
+    glUniformMatrix4fv(location, count, transpose, v);
+}
+
+void Program::setUniform(GLint location, const glm::mat2& m, GLboolean transpose) {
+    setUniformMatrix2(location, glm::value_ptr(m), 1, transpose);
+}
+
+void Program::setUniform(GLint location, const glm::mat3& m, GLboolean transpose) {
+    setUniformMatrix3(location, glm::value_ptr(m), 1, transpose);
+}
+
+void Program::setUniform(GLint location, const glm::mat4& m, GLboolean transpose) {
+    setUniformMatrix4(location, glm::value_ptr(m), 1, transpose);
+}
+
+void Program::setUniform(GLint location, const glm::vec3& v) {
+    setUniform3v(location, glm::value_ptr(v));
+}
+
+void Program::setUniform(GLint location, const glm::vec4& v) {
+    setUniform4v(location, glm::value_ptr(v));
+}
+
+void Program::setUniformMatrix2(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix2(uniform(name), v, count, transpose);
+}
+
+void Program::setUniformMatrix3(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix3(uniform(name), v, count, transpose);
+}
+
+void Program::setUniformMatrix4(const GLchar* name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix4(uniform(name), v, count, transpose);
 }
 
 void Program::setUniform(const GLchar* name, const glm::mat2& m, GLboolean transpose) {
-    assert(isInUse());
-    glUniformMatrix2fv(uniform(name), 1, transpose, glm::value_ptr(m));
+    setUniform(uniform(name), m, transpose);
 }
 
 void Program::setUniform(const GLchar* name, const glm::mat3& m, GLboolean transpose) {
-    assert(isInUse());
-    glUniformMatrix3fv(uniform(name), 1, transpose, glm::value_ptr(m));
+    setUniform(uniform(name), m, transpose);
 }
 
 void Program::setUniform(const GLchar* name, const glm::mat4& m, GLboolean transpose) {
-    assert(isInUse());
-    glUniformMatrix4fv(uniform(name), 1, transpose, glm::value_ptr(m));
+    setUniform(uniform(name), m, transpose);
 }
 
 void Program::setUniform(const GLchar* uniformName, const glm::vec3& v) {
@@ -189,4 +341,172 @@ void Program::setUniform(const GLchar* uniformName, const glm::vec4& v) {
     setUniform4v(uniformName, glm::value_ptr(v));
 }
 
+void Program::setUniformMatrix2(UniformName name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix2(uniform(name), v, count, transpose);
+}
+
+void Program::setUniformMatrix3(UniformName name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix3(uniform(name), v, count, transpose);
+}
+
+void Program::setUniformMatrix4(UniformName name, const GLfloat* v, GLsizei count, GLboolean transpose) {
+    setUniformMatrix4(uniform(name), v, count, transpose);
+}
+
+void Program::setUniform(UniformName name, const glm::mat2& m, GLboolean transpose) {
+    setUniform(uniform(name), m, transpose);
+}
+
+void Program::setUniform(UniformName name, const glm::mat3& m, GLboolean transpose) {
+    setUniform(uniform(name), m, transpose);
+}
+
+void Program::setUniform(UniformName name, const glm::mat4& m, GLboolean transpose) {
+    setUniform(uniform(name), m, transpose);
+}
+
+void Program::setUniform(UniformName name, const glm::vec3& v) {
+    setUniform(uniform(name), v);
+}
+
+void Program::setUniform(UniformName name, const glm::vec4& v) {
+    setUniform(uniform(name), v);
+}
+
+void Program::_cacheLocations() {
+    std::vector<std::pair<std::string, GLint> > names;
+    GLint count = 0;
+    GLint maxLength = 0;
+    
+    //uniforms. Arrays are listed once, as "name[0]", so every element is added too
+    glGetProgramiv(_object, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(_object, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(maxLength + 1);
+    for(GLint i = 0; i < count; ++i){
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(_object, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+        std::string name(&buffer[0], length);
+        
+        //uniforms in uniform blocks don't have locations
+        GLint location = glGetUniformLocation(_object, name.c_str());
+        if(location == -1)
+            continue;
+        names.push_back(std::make_pair(name, location));
+        
+        if(name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0){
+            std::string arrayName = name.substr(0, name.size() - 3);
+            names.push_back(std::make_pair(arrayName, location));
+            for(GLint element = 1; element < size; ++element){
+                std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+                GLint elementLocation = glGetUniformLocation(_object, elementName.c_str());
+                if(elementLocation != -1)
+                    names.push_back(std::make_pair(elementName, elementLocation));
+            }
+        }
+    }
+    _buildTable(_uniforms, names);
+    
+    //attributes
+    names.clear();
+    glGetProgramiv(_object, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(_object, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    buffer.resize(maxLength + 1);
+    for(GLint i = 0; i < count; ++i){
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(_object, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+        std::string name(&buffer[0], length);
+        
+        //built in attributes like gl_VertexID don't have locations
+        GLint location = glGetAttribLocation(_object, name.c_str());
+        if(location != -1)
+            names.push_back(std::make_pair(name, location));
+    }
+    _buildTable(_attribs, names);
+}
 
+void Program::_buildTable(std::vector<Location>& table, const std::vector<std::pair<std::string, GLint> >& names) {
+    //a power of two, at most half full, so probe sequences stay short
+    size_t capacity = 8;
+    while(capacity < names.size() * 2)
+        capacity *= 2;
+    
+    Location empty = { std::string(), 0, -1, false };
+    table.assign(capacity, empty);
+    for(size_t i = 0; i < names.size(); ++i){
+        unsigned hash = HashUniformName(names[i].first.c_str());
+        size_t slot = hash & (capacity - 1);
+        bool collides = false;
+        while(table[slot].location != -1 && table[slot].name != names[i].first){
+            //names with the same hash have the same probe sequence, so every collision is found here
+            if(table[slot].hash == hash){
+                table[slot].collides = true;
+                collides = true;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table[slot].name = names[i].first;
+        table[slot].hash = hash;
+        table[slot].location = names[i].second;
+        table[slot].collides = table[slot].collides || collides;
+    }
+}
+
+GLint Program::_findLocation(const std::vector<Location>& table, const GLchar* name) {
+    unsigned hash = HashUniformName(name);
+    size_t mask = table.size() - 1;
+    for(size_t slot = hash & mask; table[slot].location != -1; slot = (slot + 1) & mask){
+        if(table[slot].hash == hash && table[slot].name == name)
+            return table[slot].location;
+    }
+    return -1;
+}
+
+GLint Program::_findLocation(const std::vector<Location>& table, UniformName name) {
+    size_t mask = table.size() - 1;
+    for(size_t slot = name.hash() & mask; table[slot].location != -1; slot = (slot + 1) & mask){
+        if(table[slot].hash == name.hash()){
+            //two names in the program have this hash, so the hash alone isn't enough
+            if(table[slot].collides)
+                return _findLocation(table, name.name());
+            //a name that isn't in the program can still have the same hash as one that is
+            assert(table[slot].name == name.name());
+            return table[slot].location;
+        }
+    }
+    return -1;
+}
+
+void Program::_checkLinkStatus() {
+    //throw exception if linking failed
+    GLint status;
+    glGetProgramiv(_object, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::string msg("Program linking failure: ");
+        
+        GLint infoLogLength;
+        glGetProgramiv(_object, GL_INFO_LOG_LENGTH, &infoLogLength);
+        char* strInfoLog = new char[infoLogLength + 1];
+        glGetProgramInfoLog(_object, infoLogLength, NULL, strInfoLog);
+        msg += strInfoLog;
+        delete[] strInfoLog;
+        
+        glDeleteProgram(_object); _object = 0;
+        throw std::runtime_error(msg);
+    }
+}
+
+void Program::_linked() {
+    _cacheLocations();
+    
+    //bind the blocks that every program shares
+    std::map<std::string, GLuint>::const_iterator it;
+    for(it = gUniformBlockBindings.begin(); it != gUniformBlockBindings.end(); ++it){
+        GLuint blockIndex = glGetUniformBlockIndex(_object, it->first.c_str());
+        if(blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(_object, blockIndex, it->second);
+    }
+}
@@ -19,11 +19,53 @@
 #pragma once
 
 #include "Shader.h"
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 
 namespace tdogl {
 
+    /**
+     The hash that tdogl::Program uses to look up uniform and attribute names
+     (32 bit FNV-1a). It's constexpr, so string literals can be hashed at compile time.
+     */
+    constexpr unsigned HashUniformName(const GLchar* name, unsigned hash = 2166136261u) {
+        return *name ? HashUniformName(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+    }
+
+    /**
+     A uniform name along with its hash, so tdogl::Program can find the uniform
+     without hashing the name again.
+
+     Make them with the `_uniform` literal, e.g. `"camera"_uniform`, or as constants.
+     The hash is worked out at compile time when the name is a constant:
+
+         using namespace tdogl::literals;
+         static constexpr UniformName kCamera = "camera"_uniform;
+         program->setUniform(kCamera, matrix);
+     */
+    class UniformName {
+    public:
+        constexpr explicit UniformName(const GLchar* name) : _name(name), _hash(HashUniformName(name)) {}
+
+        /** the name */
+        constexpr const GLchar* name() const { return _name; }
+
+        /** the hash of the name, from HashUniformName */
+        constexpr unsigned hash() const { return _hash; }
+
+    private:
+        const GLchar* _name;
+        unsigned _hash;
+    };
+
+    namespace literals {
+        /** Makes a tdogl::UniformName from a string literal, e.g. `"camera"_uniform` */
+        constexpr UniformName operator"" _uniform(const GLchar* name, size_t) {
+            return UniformName(name);
+        }
+    }
+
     /**
      Represents an OpenGL program made by linking shaders.
      */
@@ -39,6 +81,26 @@ namespace tdogl {
          @see tdogl::Shader
          */
         Program(const std::vector<Shader>& shaders);
+        
+        /**
+         Creates a program from a binary returned by `binary`, with glProgramBinary,
+         which skips compiling and linking.
+         
+         Binaries only work with the same driver and GPU that made them, so the
+         driver may reject one, e.g. after a driver update.
+         
+         @param binaryFormat  The format returned by `binary`
+         @param binary  The binary returned by `binary`
+         @param size  The size of `binary` in bytes
+         @result A new program. The caller owns it.
+         
+         @throws std::exception if the driver rejects the binary, in which case the
+                 program has to be compiled from source instead
+         
+         @see tdogl::ProgramCache
+         */
+        static Program* programFromBinary(GLenum binaryFormat, const void* binary, GLsizei size);
+        
         ~Program();
         
         
@@ -55,19 +117,70 @@ namespace tdogl {
         
         /**
          @result The attribute index for the given name, as returned from glGetAttribLocation.
+         
+         The active attributes are all looked up once when the program is linked, so
+         this is a hash table lookup, not a call into the driver.
          */
         GLint attrib(const GLchar* attribName) const;
         
         
         /**
          @result The uniform index for the given name, as returned from glGetUniformLocation.
+         
+         The active uniforms are all looked up once when the program is linked, so
+         this is a hash table lookup, not a call into the driver. Elements of arrays
+         can be looked up with or without the index, e.g. "lights[2].position" or
+         "weights[0]" or "weights".
          */
         GLint uniform(const GLchar* uniformName) const;
+        
+        /**
+         Same as the other `uniform`, except the name is already hashed, so finding it
+         only compares hashes. In debug builds, the name is compared too, to catch a
+         name that isn't in the program but has the same hash as one that is.
+         */
+        GLint uniform(UniformName uniformName) const;
+        
+        /**
+         Binds a uniform block in this program to a uniform buffer binding point,
+         with glUniformBlockBinding.
+         
+         @throws std::exception if the program has no active block with that name
+         */
+        void bindUniformBlock(const GLchar* blockName, GLuint bindingPoint);
+        
+        /**
+         Makes every program linked from now on bind its uniform block called
+         `blockName`, if it has one, to `bindingPoint`. This lets all programs share
+         one tdogl::UniformBuffer per block, without binding each program's block by
+         hand.
+         */
+        static void setUniformBlockBinding(const std::string& blockName, GLuint bindingPoint);
+        
+        /**
+         The linked program as a driver-specific binary, from glGetProgramBinary, for
+         saving and passing to `programFromBinary` later. Programs are linked with
+         GL_PROGRAM_BINARY_RETRIEVABLE_HINT when program binaries are supported.
+         
+         @param binaryFormat  Set to the format of the binary
+         @result The binary, or an empty vector if program binaries aren't supported
+         */
+        std::vector<unsigned char> binary(GLenum& binaryFormat) const;
+        
+        /**
+         @result true if the context supports program binaries (OpenGL 4.1 or
+                 ARB_get_program_binary, with at least one binary format)
+         */
+        static bool binariesSupported();
 
         /**
          Setters for attribute and uniform variables.
 
          These are convenience methods for the glVertexAttrib* and glUniform* functions.
+         
+         Each setter takes either a name, or an index from `attrib` or `uniform`. Look
+         the index up once and keep it to avoid looking up the name every time. The
+         uniform setters also take a tdogl::UniformName, which avoids hashing the name.
          */
 #define _TDOGL_PROGRAM_ATTRIB_N_UNIFORM_SETTERS(OGL_TYPE) \
         void setAttrib(const GLchar* attribName, OGL_TYPE v0); \
@@ -89,6 +202,36 @@ namespace tdogl {
         void setUniform2v(const GLchar* uniformName, const OGL_TYPE* v, GLsizei count=1); \
         void setUniform3v(const GLchar* uniformName, const OGL_TYPE* v, GLsizei count=1); \
         void setUniform4v(const GLchar* uniformName, const OGL_TYPE* v, GLsizei count=1); \
+\
+        void setAttrib(GLint attrib, OGL_TYPE v0); \
+        void setAttrib(GLint attrib, OGL_TYPE v0, OGL_TYPE v1); \
+        void setAttrib(GLint attrib, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2); \
+        void setAttrib(GLint attrib, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3); \
+\
+        void setAttrib1v(GLint attrib, const OGL_TYPE* v); \
+        void setAttrib2v(GLint attrib, const OGL_TYPE* v); \
+        void setAttrib3v(GLint attrib, const OGL_TYPE* v); \
+        void setAttrib4v(GLint attrib, const OGL_TYPE* v); \
+\
+        void setUniform(GLint uniform, OGL_TYPE v0); \
+        void setUniform(GLint uniform, OGL_TYPE v0, OGL_TYPE v1); \
+        void setUniform(GLint uniform, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2); \
+        void setUniform(GLint uniform, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3); \
+\
+        void setUniform1v(GLint uniform, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform2v(GLint uniform, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform3v(GLint uniform, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform4v(GLint uniform, const OGL_TYPE* v, GLsizei count=1); \
+\
+        void setUniform(UniformName uniformName, OGL_TYPE v0); \
+        void setUniform(UniformName uniformName, OGL_TYPE v0, OGL_TYPE v1); \
+        void setUniform(UniformName uniformName, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2); \
+        void setUniform(UniformName uniformName, OGL_TYPE v0, OGL_TYPE v1, OGL_TYPE v2, OGL_TYPE v3); \
+\
+        void setUniform1v(UniformName uniformName, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform2v(UniformName uniformName, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform3v(UniformName uniformName, const OGL_TYPE* v, GLsizei count=1); \
+        void setUniform4v(UniformName uniformName, const OGL_TYPE* v, GLsizei count=1); \
 
         _TDOGL_PROGRAM_ATTRIB_N_UNIFORM_SETTERS(GLfloat)
         _TDOGL_PROGRAM_ATTRIB_N_UNIFORM_SETTERS(GLdouble)
@@ -103,10 +246,46 @@ namespace tdogl {
         void setUniform(const GLchar* uniformName, const glm::mat4& m, GLboolean transpose=GL_FALSE);
         void setUniform(const GLchar* uniformName, const glm::vec3& v);
         void setUniform(const GLchar* uniformName, const glm::vec4& v);
+        void setUniformMatrix2(GLint uniform, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniformMatrix3(GLint uniform, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniformMatrix4(GLint uniform, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniform(GLint uniform, const glm::mat2& m, GLboolean transpose=GL_FALSE);
+        void setUniform(GLint uniform, const glm::mat3& m, GLboolean transpose=GL_FALSE);
+        void setUniform(GLint uniform, const glm::mat4& m, GLboolean transpose=GL_FALSE);
+        void setUniform(GLint uniform, const glm::vec3& v);
+        void setUniform(GLint uniform, const glm::vec4& v);
+        void setUniformMatrix2(UniformName uniformName, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniformMatrix3(UniformName uniformName, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniformMatrix4(UniformName uniformName, const GLfloat* v, GLsizei count=1, GLboolean transpose=GL_FALSE);
+        void setUniform(UniformName uniformName, const glm::mat2& m, GLboolean transpose=GL_FALSE);
+        void setUniform(UniformName uniformName, const glm::mat3& m, GLboolean transpose=GL_FALSE);
+        void setUniform(UniformName uniformName, const glm::mat4& m, GLboolean transpose=GL_FALSE);
+        void setUniform(UniformName uniformName, const glm::vec3& v);
+        void setUniform(UniformName uniformName, const glm::vec4& v);
 
         
     private:
+        friend class AsyncProgram;
+        
+        //a slot in an open addressing hash table of names. Empty slots have a location of -1
+        struct Location {
+            std::string name;
+            unsigned hash;
+            GLint location;
+            bool collides; //another name in the table has the same hash
+        };
+        
         GLuint _object;
+        std::vector<Location> _attribs;
+        std::vector<Location> _uniforms;
+        
+        Program();
+        void _checkLinkStatus();
+        void _linked();
+        void _cacheLocations();
+        static void _buildTable(std::vector<Location>& table, const std::vector<std::pair<std::string, GLint> >& names);
+        static GLint _findLocation(const std::vector<Location>& table, const GLchar* name);
+        static GLint _findLocation(const std::vector<Location>& table, UniformName name);
         
         //copying disabled
         Program(const Program&);
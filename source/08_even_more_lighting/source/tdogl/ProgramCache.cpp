@@ -0,0 +1,142 @@
+/*
+ tdogl::ProgramCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "ProgramCache.h"
+#include "FileUtils.h"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+
+using namespace tdogl;
+
+//change this whenever the way cache files are made changes, so old ones get remade
+static const char kCacheVersion[] = "tdogl-program-cache-1";
+
+//first bytes of every cache file, followed by the binary format then the binary
+static const char kFileMagic[4] = { 'T', 'D', 'P', 'B' };
+static const size_t kHeaderSize = sizeof(kFileMagic) + sizeof(unsigned);
+
+static std::string ReadSourceFile(const std::string& filePath) {
+    std::vector<unsigned char> contents = ReadFileContents(filePath);
+    return std::string(contents.begin(), contents.end());
+}
+
+static unsigned long long HashString(const char* str, unsigned long long hash) {
+    //glGetString returns NULL if something is wrong with the context
+    if(!str)
+        str = "";
+    //include the terminator, so "ab"+"c" and "a"+"bc" hash differently
+    return HashBytes(str, strlen(str) + 1, hash);
+}
+
+static bool ReadBinaryFile(const std::string& filePath, GLenum& binaryFormat, std::vector<unsigned char>& binary) {
+    std::vector<unsigned char> contents;
+    try {
+        contents = ReadFileContents(filePath);
+    } catch(const std::exception&) {
+        return false;
+    }
+
+    if(contents.size() <= kHeaderSize || memcmp(&contents[0], kFileMagic, sizeof(kFileMagic)) != 0)
+        return false;
+
+    unsigned format = 0;
+    memcpy(&format, &contents[sizeof(kFileMagic)], sizeof(format));
+    binaryFormat = (GLenum)format;
+    binary.assign(contents.begin() + kHeaderSize, contents.end());
+    return true;
+}
+
+static bool WriteBinaryFile(const std::string& filePath, GLenum binaryFormat, const std::vector<unsigned char>& binary) {
+    FILE* f = CreateTempFile(filePath);
+    if(!f)
+        return false;
+
+    unsigned format = (unsigned)binaryFormat;
+    bool ok = (fwrite(kFileMagic, 1, sizeof(kFileMagic), f) == sizeof(kFileMagic)) &&
+              fwrite(&format, sizeof(format), 1, f) == 1 &&
+              fwrite(&binary[0], 1, binary.size(), f) == binary.size();
+    return FinishTempFile(f, filePath, ok);
+}
+
+ProgramCache::ProgramCache(const std::string& directory) :
+    _directory(directory)
+{
+    MakeDirectory(_directory);
+}
+
+std::unique_ptr<Program> ProgramCache::load(const std::string& vertexShaderPath,
+                                            const std::string& fragmentShaderPath)
+{
+    std::vector<ShaderSource> sources(2);
+    sources[0].type = GL_VERTEX_SHADER;
+    sources[0].code = ReadSourceFile(vertexShaderPath);
+    sources[1].type = GL_FRAGMENT_SHADER;
+    sources[1].code = ReadSourceFile(fragmentShaderPath);
+    return load(sources);
+}
+
+std::unique_ptr<Program> ProgramCache::load(const std::vector<ShaderSource>& sources) {
+    bool binariesSupported = Program::binariesSupported();
+    std::string cachePath;
+
+    if(binariesSupported){
+        //binaries only work on the driver that made them, so it's part of the key
+        unsigned long long hash = HashBytes(kCacheVersion, sizeof(kCacheVersion));
+        hash = HashString((const char*)glGetString(GL_VENDOR), hash);
+        hash = HashString((const char*)glGetString(GL_RENDERER), hash);
+        hash = HashString((const char*)glGetString(GL_VERSION), hash);
+        for(size_t i = 0; i < sources.size(); ++i){
+            unsigned type = (unsigned)sources[i].type;
+            hash = HashBytes(&type, sizeof(type), hash);
+            hash = HashString(sources[i].code.c_str(), hash);
+        }
+
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.tdprog", hash);
+        cachePath = _directory + "/" + fileName;
+
+        GLenum binaryFormat = 0;
+        std::vector<unsigned char> binary;
+        if(ReadBinaryFile(cachePath, binaryFormat, binary)){
+            try {
+                return std::unique_ptr<Program>(Program::programFromBinary(binaryFormat, &binary[0], (GLsizei)binary.size()));
+            } catch(const std::exception&) {
+                //the driver rejected the binary, e.g. after a driver update. Compile it again.
+            }
+        }
+    }
+
+    std::vector<Shader> shaders;
+    for(size_t i = 0; i < sources.size(); ++i)
+        shaders.push_back(Shader(sources[i].code, sources[i].type));
+    std::unique_ptr<Program> program(new Program(shaders));
+
+    if(binariesSupported){
+        GLenum binaryFormat = 0;
+        std::vector<unsigned char> binary = program->binary(binaryFormat);
+        //if this fails the cache directory isn't writable, so the program will be compiled again next time
+        if(!binary.empty())
+            WriteBinaryFile(cachePath, binaryFormat, binary);
+    }
+    return program;
+}
+
+const std::string& ProgramCache::directory() const {
+    return _directory;
+}
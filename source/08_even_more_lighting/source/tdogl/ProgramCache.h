@@ -0,0 +1,85 @@
+/*
+ tdogl::ProgramCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <GL/glew.h>
+#include "Program.h"
+#include <string>
+#include <memory>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A directory of linked program binaries, so shaders don't have to be compiled
+     and linked again every time the app starts.
+
+     The first time a program is loaded it is compiled from source as usual, then
+     its binary (see tdogl::Program::binary) is saved into the cache directory.
+     After that, loading the same program hands the saved binary straight to the
+     driver with glProgramBinary.
+
+     Binaries only work on the driver that made them, so cache files are named
+     after a hash of the shader sources along with GL_VENDOR, GL_RENDERER and
+     GL_VERSION. If the driver rejects a cached binary anyway, the program is
+     compiled from source and the cache file is replaced. When the context doesn't
+     support program binaries at all, programs are always compiled from source.
+     The whole directory can safely be deleted at any time.
+     */
+    class ProgramCache {
+    public:
+        /** the source code and type of one shader in a program */
+        struct ShaderSource {
+            GLenum type;
+            std::string code;
+        };
+
+        /**
+         @param directory  The directory to keep the cache files in. It is created if
+                           it doesn't exist.
+         */
+        explicit ProgramCache(const std::string& directory);
+
+        /**
+         Loads a program made of a vertex shader and a fragment shader, from the
+         cache if possible.
+
+         @param vertexShaderPath  The path to the vertex shader source file
+         @param fragmentShaderPath  The path to the fragment shader source file
+         @throws std::exception if a file can't be read, or the shaders fail to
+                 compile or link
+         */
+        std::unique_ptr<Program> load(const std::string& vertexShaderPath,
+                                      const std::string& fragmentShaderPath);
+
+        /**
+         Loads a program made of any shaders, from the cache if possible.
+
+         @throws std::exception if the shaders fail to compile or link
+         */
+        std::unique_ptr<Program> load(const std::vector<ShaderSource>& sources);
+
+        /** the directory that the cache files are kept in */
+        const std::string& directory() const;
+
+    private:
+        std::string _directory;
+    };
+
+}
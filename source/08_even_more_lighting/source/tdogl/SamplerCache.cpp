@@ -0,0 +1,95 @@
+/*
+ tdogl::SamplerCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "SamplerCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <map>
+
+using namespace tdogl;
+
+namespace {
+    struct SamplerKey {
+        GLint minFilter;
+        GLint magFilter;
+        GLint wrapMode;
+        GLfloat anisotropy;
+
+        bool operator<(const SamplerKey& other) const {
+            if(minFilter != other.minFilter) return minFilter < other.minFilter;
+            if(magFilter != other.magFilter) return magFilter < other.magFilter;
+            if(wrapMode != other.wrapMode) return wrapMode < other.wrapMode;
+            return anisotropy < other.anisotropy;
+        }
+    };
+}
+
+static std::map<SamplerKey, GLuint> gSamplers;
+static GLfloat gAnisotropyLimit = FLT_MAX;
+
+static void ApplyAnisotropy(GLuint sampler, GLfloat anisotropy) {
+    if(!GLEW_EXT_texture_filter_anisotropic)
+        return;
+
+    GLfloat driverMax = 1.0f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &driverMax);
+    glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::max(1.0f, std::min(anisotropy, std::min(gAnisotropyLimit, driverMax))));
+}
+
+bool SamplerCache::isSupported() {
+    return GLEW_VERSION_3_3 || GLEW_ARB_sampler_objects;
+}
+
+GLuint SamplerCache::sampler(GLint minFilter, GLint magFilter, GLint wrapMode, GLfloat anisotropy) {
+    if(!isSupported())
+        return 0;
+
+    SamplerKey key = { minFilter, magFilter, wrapMode, anisotropy };
+    std::map<SamplerKey, GLuint>::iterator found = gSamplers.find(key);
+    if(found != gSamplers.end())
+        return found->second;
+
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrapMode);
+    ApplyAnisotropy(sampler, anisotropy);
+    gSamplers[key] = sampler;
+    return sampler;
+}
+
+void SamplerCache::setAnisotropyLimit(GLfloat limit) {
+    gAnisotropyLimit = limit;
+    std::map<SamplerKey, GLuint>::iterator it;
+    for(it = gSamplers.begin(); it != gSamplers.end(); ++it)
+        ApplyAnisotropy(it->second, it->first.anisotropy);
+}
+
+GLfloat SamplerCache::anisotropyLimit() {
+    return gAnisotropyLimit;
+}
+
+void SamplerCache::clear() {
+    std::map<SamplerKey, GLuint>::iterator it;
+    for(it = gSamplers.begin(); it != gSamplers.end(); ++it)
+        glDeleteSamplers(1, &it->second);
+    gSamplers.clear();
+}
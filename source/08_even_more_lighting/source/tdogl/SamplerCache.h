@@ -0,0 +1,75 @@
+/*
+ tdogl::SamplerCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <GL/glew.h>
+
+namespace tdogl {
+
+    /**
+     Shares OpenGL sampler objects between textures.
+
+     A sampler object holds the filtering and wrapping settings that would
+     otherwise be set on every texture with glTexParameteri. Textures with the same
+     settings share one sampler, so changing a setting for every texture (e.g.
+     lowering the anisotropy when the frame rate drops) only touches a handful of
+     samplers.
+
+     Sampler objects need OpenGL 3.3 or ARB_sampler_objects. Without them
+     `sampler` returns 0 and the settings stored in each tdogl::Texture are used
+     instead. Only use this on the thread that owns the OpenGL context.
+     */
+    class SamplerCache {
+    public:
+        /** true if the context supports sampler objects */
+        static bool isSupported();
+
+        /**
+         The shared sampler with the given settings, which is made the first time
+         it's asked for. Bind it with glBindSampler.
+
+         @param minFilter  GL_NEAREST, GL_LINEAR, or one of the GL_*_MIPMAP_* filters
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         @param anisotropy  The maximum anisotropy, where 1 turns anisotropic filtering
+                            off. Limited by `anisotropyLimit` and the driver.
+         @result The sampler object, or 0 if sampler objects aren't supported
+         */
+        static GLuint sampler(GLint minFilter, GLint magFilter, GLint wrapMode, GLfloat anisotropy = 1.0f);
+
+        /**
+         Limits the anisotropy of every sampler, including the ones that already
+         exist. The default is no limit (other than the driver's).
+         */
+        static void setAnisotropyLimit(GLfloat limit);
+
+        /** the limit set with `setAnisotropyLimit` */
+        static GLfloat anisotropyLimit();
+
+        /**
+         Deletes all the sampler objects. Call this before the context is destroyed.
+         Samplers asked for afterwards are made again.
+         */
+        static void clear();
+
+    private:
+        SamplerCache();
+    };
+
+}
@@ -17,45 +17,171 @@
  */
 
 #include "Texture.h"
+#include "SamplerCache.h"
+#include "TextureFormats.h"
+#include <algorithm>
 #include <stdexcept>
 
 using namespace tdogl;
 
-static GLenum TextureFormatForBitmapFormat(Bitmap::Format format, bool srgb)
+// set with Texture::setUseImmutableStorage
+static bool gUseImmutableStorage = true;
+
+static GLenum TextureFormatForCompressedFormat(CompressedBitmap::Format format, bool srgb)
 {
     switch (format) {
-        case Bitmap::Format_Grayscale: return GL_LUMINANCE;
-        case Bitmap::Format_GrayscaleAlpha: return GL_LUMINANCE_ALPHA;
-        case Bitmap::Format_RGB: return (srgb ? GL_SRGB : GL_RGB);
-        case Bitmap::Format_RGBA: return (srgb ? GL_SRGB_ALPHA : GL_RGBA);
-        default: throw std::runtime_error("Unrecognised Bitmap::Format");
+        case CompressedBitmap::Format_BC1: return (srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+        case CompressedBitmap::Format_BC3: return (srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+        case CompressedBitmap::Format_BC7: return (srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM);
+        case CompressedBitmap::Format_ETC2_RGB: return (srgb ? GL_COMPRESSED_SRGB8_ETC2 : GL_COMPRESSED_RGB8_ETC2);
+        default: throw std::runtime_error("Unrecognised CompressedBitmap::Format");
     }
 }
 
-Texture::Texture(const Bitmap& bitmap, GLint minMagFiler, GLint wrapMode) :
+static void SetUnpackRowLength(const BitmapView& view)
+{
+    if(view.rowStride() % view.format() != 0)
+        throw std::runtime_error("Bitmap view row stride must be a whole number of pixels");
+    
+    //rows of bitmap pixels are not padded to 4 bytes, but may be part of a wider image
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, view.isContiguous() ? 0 : (GLint)(view.rowStride() / view.format()));
+}
+
+static void UploadRect(const BitmapView& view, GLint x, GLint y, GLint level, bool immutable)
+{
+    SetUnpackRowLength(view);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    level,
+                    x,
+                    y,
+                    (GLsizei)view.width(),
+                    (GLsizei)view.height(),
+                    PixelFormatForBitmapFormat(view.format(), immutable),
+                    GL_UNSIGNED_BYTE,
+                    view.rowPointer(0));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+static void UploadCompressedLevel(GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                                  size_t size, const void* data, bool immutable)
+{
+    if(immutable)
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, internalFormat, (GLsizei)size, data);
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, (GLsizei)size, data);
+}
+
+Texture::Texture(const BitmapView& bitmap, GLint minMagFiler, GLint wrapMode) :
     _originalWidth((GLfloat)bitmap.width()),
-    _originalHeight((GLfloat)bitmap.height())
+    _originalHeight((GLfloat)bitmap.height()),
+    _uploadFence(NULL),
+    _pendingUploads(0)
 {
-    glGenTextures(1, &_object);
+    _create(1, minMagFiler, minMagFiler, wrapMode);
+    _allocate(1, bitmap.format(), true, (GLsizei)bitmap.width(), (GLsizei)bitmap.height());
+    UploadRect(bitmap, 0, 0, 0, _immutable);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const Bitmap& bitmap,
+                 const std::vector<Bitmap>& mipmaps,
+                 GLint minFilter,
+                 GLint magFilter,
+                 GLint wrapMode) :
+    _originalWidth((GLfloat)bitmap.width()),
+    _originalHeight((GLfloat)bitmap.height()),
+    _uploadFence(NULL),
+    _pendingUploads(0)
+{
+    for(size_t i = 0; i < mipmaps.size(); ++i){
+        if(mipmaps[i].format() != bitmap.format())
+            throw std::runtime_error("Mipmaps must have the same format as the base bitmap");
+    }
+    
+    GLint levelCount = (GLint)mipmaps.size() + 1;
+    _create(levelCount, minFilter, magFilter, wrapMode);
+    _allocate(levelCount, bitmap.format(), true, (GLsizei)bitmap.width(), (GLsizei)bitmap.height());
+    UploadRect(bitmap, 0, 0, 0, _immutable);
+    for(size_t i = 0; i < mipmaps.size(); ++i)
+        UploadRect(mipmaps[i], 0, 0, (GLint)i + 1, _immutable);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const CompressedBitmap& image,
+                 const std::vector<CompressedBitmap>& mipmaps,
+                 GLint minFilter,
+                 GLint magFilter,
+                 GLint wrapMode) :
+    _originalWidth((GLfloat)image.width()),
+    _originalHeight((GLfloat)image.height()),
+    _uploadFence(NULL),
+    _pendingUploads(0)
+{
+    for(size_t i = 0; i < mipmaps.size(); ++i){
+        if(mipmaps[i].format() != image.format() || mipmaps[i].isSRGB() != image.isSRGB())
+            throw std::runtime_error("Mipmaps must have the same format as the base image");
+    }
+    
+    GLint levelCount = (GLint)mipmaps.size() + 1;
+    GLenum internalFormat = TextureFormatForCompressedFormat(image.format(), image.isSRGB());
+    _create(levelCount, minFilter, magFilter, wrapMode);
+    if(_immutable)
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, (GLsizei)image.width(), (GLsizei)image.height());
+    for(size_t i = 0; i <= mipmaps.size(); ++i){
+        const CompressedBitmap& level = (i == 0) ? image : mipmaps[i - 1];
+        UploadCompressedLevel((GLint)i, internalFormat, (GLsizei)level.width(), (GLsizei)level.height(),
+                              level.dataSize(), level.data(), _immutable);
+        _videoMemorySize += level.dataSize();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const TextureFile& file,
+                 GLint minFilter,
+                 GLint magFilter,
+                 GLint wrapMode) :
+    _originalWidth((GLfloat)file.levelWidth(0)),
+    _originalHeight((GLfloat)file.levelHeight(0)),
+    _uploadFence(NULL),
+    _pendingUploads(0)
+{
+    _minFilter = minFilter;
+    _magFilter = magFilter;
+    _wrapMode = wrapMode;
+    _uploadFile(file, 0);
+}
+
+Texture::Texture(GLsizei width,
+                 GLsizei height,
+                 Bitmap::Format format,
+                 GLint levelCount,
+                 GLint minFilter,
+                 GLint magFilter,
+                 GLint wrapMode,
+                 bool srgb) :
+    _originalWidth((GLfloat)width),
+    _originalHeight((GLfloat)height),
+    _uploadFence(NULL),
+    _pendingUploads(0)
+{
+    _create(levelCount, minFilter, magFilter, wrapMode);
+    _allocate(levelCount, format, srgb, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::update(const BitmapView& view, GLint x, GLint y, GLint level)
+{
+    _checkFormat(view);
     glBindTexture(GL_TEXTURE_2D, _object);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minMagFiler);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, minMagFiler);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
-    glTexImage2D(GL_TEXTURE_2D,
-                 0, 
-                 TextureFormatForBitmapFormat(bitmap.format(), true),
-                 (GLsizei)bitmap.width(), 
-                 (GLsizei)bitmap.height(),
-                 0, 
-                 TextureFormatForBitmapFormat(bitmap.format(), false),
-                 GL_UNSIGNED_BYTE, 
-                 bitmap.pixelBuffer());
+    UploadRect(view, x, y, level, _immutable);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
 {
+    if(_uploadFence)
+        glDeleteSync(_uploadFence);
     glDeleteTextures(1, &_object);
 }
 
@@ -73,3 +199,161 @@ GLfloat Texture::originalHeight() const
 {
     return _originalHeight;
 }
+
+GLuint Texture::sampler(GLfloat anisotropy) const
+{
+    return SamplerCache::sampler(_minFilter, _magFilter, _wrapMode, anisotropy);
+}
+
+void Texture::setUseImmutableStorage(bool enabled)
+{
+    gUseImmutableStorage = enabled;
+}
+
+size_t Texture::videoMemorySize() const
+{
+    return _videoMemorySize;
+}
+
+bool Texture::isReady() const
+{
+    if(_pendingUploads > 0)
+        return false;
+    if(_uploadFence){
+        //a timeout of zero just checks the fence, without waiting
+        if(glClientWaitSync(_uploadFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(_uploadFence);
+        _uploadFence = NULL;
+    }
+    return true;
+}
+
+void Texture::_checkFormat(const BitmapView& view) const
+{
+    //the pixel format passed to glTexSubImage2D has to match how the storage was made,
+    //e.g. GL_RED for a sized gray texture, so other formats can't be uploaded as they are
+    if(view.format() != _format)
+        throw std::runtime_error("Bitmap view is not the same format as the texture");
+}
+
+void Texture::_updateFromBuffer(size_t offset, GLsizei width, GLsizei height, GLint x, GLint y, GLint level)
+{
+    //with a GL_PIXEL_UNPACK_BUFFER bound, the data pointer is an offset into the buffer
+    glBindTexture(GL_TEXTURE_2D, _object);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    level,
+                    x,
+                    y,
+                    width,
+                    height,
+                    PixelFormatForBitmapFormat(_format, _immutable),
+                    GL_UNSIGNED_BYTE,
+                    (const GLvoid*)offset);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::_create(GLint levelCount, GLint minFilter, GLint magFilter, GLint wrapMode)
+{
+    _minFilter = minFilter;
+    _magFilter = magFilter;
+    _wrapMode = wrapMode;
+    _format = (Bitmap::Format)0;
+    _videoMemorySize = 0;
+    _streaming = false;
+    _immutable = gUseImmutableStorage && (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage);
+    
+    glGenTextures(1, &_object);
+    glBindTexture(GL_TEXTURE_2D, _object);
+    //a sampler from `sampler()` overrides these while it's bound, but they're still
+    //needed when the texture is drawn without one
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+}
+
+void Texture::_allocate(GLint levelCount, Bitmap::Format format, bool srgb, GLsizei width, GLsizei height)
+{
+    _format = format;
+    
+    //gray bitmaps are stored as red textures, which only look right if they can be swizzled
+    if(!CanUseSizedFormat(format))
+        _immutable = false;
+    
+    for(GLint level = 0; level < levelCount; ++level){
+        //drivers pad RGB pixels out to four bytes
+        size_t bytesPerPixel = (format == Bitmap::Format_RGB) ? 4 : (size_t)format;
+        _videoMemorySize += (size_t)std::max(1, width >> level) * (size_t)std::max(1, height >> level) * bytesPerPixel;
+    }
+    
+    if(_immutable){
+        //immutable storage has every level from the start, so the driver never has to check completeness again
+        glTexStorage2D(GL_TEXTURE_2D, levelCount, SizedFormatForBitmapFormat(format, srgb), width, height);
+        SetGraySwizzle(GL_TEXTURE_2D, format);
+    } else {
+        for(GLint level = 0; level < levelCount; ++level){
+            glTexImage2D(GL_TEXTURE_2D,
+                         level,
+                         TextureFormatForBitmapFormat(format, srgb),
+                         std::max(1, width >> level),
+                         std::max(1, height >> level),
+                         0,
+                         TextureFormatForBitmapFormat(format, false),
+                         GL_UNSIGNED_BYTE,
+                         NULL);
+        }
+    }
+}
+
+void Texture::_uploadFile(const TextureFile& file, unsigned firstLevel)
+{
+    GLint levelCount = (GLint)(file.levelCount() - firstLevel);
+    GLsizei width = (GLsizei)file.levelWidth(firstLevel);
+    GLsizei height = (GLsizei)file.levelHeight(firstLevel);
+    _create(levelCount, _minFilter, _magFilter, _wrapMode);
+    
+    if(file.isCompressed()){
+        GLenum internalFormat = TextureFormatForCompressedFormat(file.compressedFormat(), file.isSRGB());
+        if(_immutable)
+            glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, width, height);
+        for(GLint i = 0; i < levelCount; ++i){
+            unsigned fileLevel = firstLevel + (unsigned)i;
+            UploadCompressedLevel(i, internalFormat, (GLsizei)file.levelWidth(fileLevel), (GLsizei)file.levelHeight(fileLevel),
+                                  file.levelSize(fileLevel), file.levelData(fileLevel), _immutable);
+            _videoMemorySize += file.levelSize(fileLevel);
+        }
+    } else {
+        _allocate(levelCount, file.bitmapFormat(), file.isSRGB(), width, height);
+        for(GLint i = 0; i < levelCount; ++i){
+            unsigned fileLevel = firstLevel + (unsigned)i;
+            //the level data is tightly packed, so it can be viewed as a bitmap without copying
+            BitmapView level(const_cast<unsigned char*>(file.levelData(fileLevel)),
+                             file.levelWidth(fileLevel),
+                             file.levelHeight(fileLevel),
+                             file.bitmapFormat());
+            UploadRect(level, 0, 0, i, _immutable);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::_release()
+{
+    if(_uploadFence){
+        glDeleteSync(_uploadFence);
+        _uploadFence = NULL;
+    }
+    glDeleteTextures(1, &_object);
+    _object = 0;
+    _videoMemorySize = 0;
+}
+
+void Texture::_setBaseLevel(GLint level)
+{
+    glBindTexture(GL_TEXTURE_2D, _object);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
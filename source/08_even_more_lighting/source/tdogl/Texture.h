@@ -19,7 +19,11 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <atomic>
+#include <vector>
 #include "Bitmap.h"
+#include "CompressedBitmap.h"
+#include "TextureFile.h"
 
 namespace tdogl {
     
@@ -29,7 +33,7 @@ namespace tdogl {
     class Texture {
     public:
         /**
-         Creates a texture from a bitmap.
+         Creates a texture from a bitmap, or a view of part of one.
          
          The texture will be loaded upside down because tdogl::Bitmap pixel data
          is ordered from the top row down, but OpenGL expects the data to
@@ -39,10 +43,103 @@ namespace tdogl {
          @param minMagFiler  GL_NEAREST or GL_LINEAR
          @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
          */
-        Texture(const Bitmap& bitmap,
+        Texture(const BitmapView& bitmap,
                 GLint minMagFiler = GL_LINEAR,
                 GLint wrapMode = GL_CLAMP_TO_EDGE);
         
+        /**
+         Creates a mipmapped texture from a bitmap and its mipmaps.
+         
+         Every mip level is uploaded as given, so the mipmaps can be made with
+         any filter (see tdogl::Bitmap::mipmaps) instead of by glGenerateMipmap.
+         
+         @param bitmap  The bitmap for mip level 0
+         @param mipmaps  The bitmaps for mip levels 1 and up, in order. Must be
+                         the same format as `bitmap`.
+         @param minFilter  One of the GL_*_MIPMAP_* filters, GL_NEAREST or GL_LINEAR
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         */
+        Texture(const Bitmap& bitmap,
+                const std::vector<Bitmap>& mipmaps,
+                GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                GLint magFilter = GL_LINEAR,
+                GLint wrapMode = GL_CLAMP_TO_EDGE);
+        
+        /**
+         Creates a texture from block compressed data, using glCompressedTexImage2D.
+         
+         The texture stays compressed in video memory. The context must support the
+         compression format (e.g. EXT_texture_compression_s3tc for BC1 and BC3).
+         
+         @param image  The compressed image for mip level 0
+         @param mipmaps  The compressed images for mip levels 1 and up, in order. Must
+                         be the same format as `image`. May be empty.
+         @param minFilter  GL_NEAREST, GL_LINEAR, or one of the GL_*_MIPMAP_* filters
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         */
+        Texture(const CompressedBitmap& image,
+                const std::vector<CompressedBitmap>& mipmaps,
+                GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                GLint magFilter = GL_LINEAR,
+                GLint wrapMode = GL_CLAMP_TO_EDGE);
+        
+        /**
+         Creates a texture from a tdogl::TextureFile, uploading every level in the file.
+         
+         The level data is passed straight from the file to OpenGL without any
+         decoding or copying, so a memory mapped file is uploaded directly from the
+         page cache.
+         
+         @param file  The texture file. Can be destroyed after the texture is made.
+         @param minFilter  GL_NEAREST, GL_LINEAR, or one of the GL_*_MIPMAP_* filters
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         */
+        Texture(const TextureFile& file,
+                GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                GLint magFilter = GL_LINEAR,
+                GLint wrapMode = GL_CLAMP_TO_EDGE);
+        
+        /**
+         Creates a texture with storage for the given size and format, but no
+         pixels yet. Fill it in with `update` or tdogl::TextureUploader.
+         
+         @param width  Width of mip level 0 in pixels
+         @param height  Height of mip level 0 in pixels
+         @param format  The format of the pixels that will be uploaded
+         @param levelCount  How many mip levels to make space for, including level 0
+         @param minFilter  GL_NEAREST, GL_LINEAR, or one of the GL_*_MIPMAP_* filters
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         @param srgb  Whether the color channels are sRGB encoded
+         */
+        Texture(GLsizei width,
+                GLsizei height,
+                Bitmap::Format format,
+                GLint levelCount = 1,
+                GLint minFilter = GL_LINEAR,
+                GLint magFilter = GL_LINEAR,
+                GLint wrapMode = GL_CLAMP_TO_EDGE,
+                bool srgb = true);
+        
+        /**
+         Replaces a rectangle of the texture with the pixels in a view, using
+         glTexSubImage2D. The rows of the view are uploaded straight from where
+         they are, even if the view is part of a larger image.
+         
+         @param view  The new pixels. Must be the same format as the texture.
+         @param x  The column of the texture to start at
+         @param y  The row of the texture to start at, counting rows in the same
+                   order as the bitmap the texture was made from
+         @param level  The mip level to update
+         
+         @throws std::exception if the view is a different format to the texture,
+                 or the texture is compressed
+         */
+        void update(const BitmapView& view, GLint x, GLint y, GLint level = 0);
+        
         /**
          Deletes the texture object with glDeleteTextures
          */
@@ -63,10 +160,65 @@ namespace tdogl {
          */
         GLfloat originalHeight() const;
         
+        /**
+         @result An estimate of how many bytes of video memory the texture uses,
+                 counting every mip level. Drivers may round up or add padding.
+         */
+        size_t videoMemorySize() const;
+        
+        /**
+         @result false while tdogl::TextureUploader is still uploading pixels into
+                 this texture, in which case it shouldn't be drawn yet. Always true
+                 for textures that don't use an uploader. Only call this on the
+                 thread that owns the OpenGL context.
+         */
+        bool isReady() const;
+        
+        /**
+         The shared sampler object with this texture's filter and wrap settings,
+         from tdogl::SamplerCache. Bind it to the same texture unit as the texture
+         with glBindSampler.
+         
+         @param anisotropy  The maximum anisotropy, where 1 is no anisotropic filtering
+         @result The sampler object, or 0 if sampler objects aren't supported, in
+                 which case the settings stored in the texture are used instead
+         */
+        GLuint sampler(GLfloat anisotropy = 1.0f) const;
+        
+        /**
+         Sets whether textures made from now on use immutable storage
+         (glTexStorage2D) when the context supports it. Immutable storage has every
+         mip level allocated up front, which lets the driver lay the texture out
+         once and skip completeness checks. Defaults to true.
+         */
+        static void setUseImmutableStorage(bool enabled);
+        
     private:
+        friend class TextureUploader;
+        friend class TextureResidency;
+        friend class TextureStreamer;
+        
         GLuint _object;
         GLfloat _originalWidth;
         GLfloat _originalHeight;
+        GLint _minFilter;
+        GLint _magFilter;
+        GLint _wrapMode;
+        Bitmap::Format _format; //0 for compressed textures
+        bool _immutable;
+        size_t _videoMemorySize;
+        bool _streaming;
+        mutable GLsync _uploadFence;
+        std::atomic<unsigned> _pendingUploads;
+        
+        void _create(GLint levelCount, GLint minFilter, GLint magFilter, GLint wrapMode);
+        void _allocate(GLint levelCount, Bitmap::Format format, bool srgb, GLsizei width, GLsizei height);
+        void _uploadFile(const TextureFile& file, unsigned firstLevel);
+        void _release();
+        void _setBaseLevel(GLint level);
+        
+        void _checkFormat(const BitmapView& view) const;
+        void _updateFromBuffer(size_t offset, GLsizei width, GLsizei height, GLint x, GLint y, GLint level);
         
         //copying disabled
         Texture(const Texture&);
@@ -0,0 +1,204 @@
+/*
+ tdogl::TextureArray
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureArray.h"
+#include "SamplerCache.h"
+#include "TextureFormats.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace tdogl;
+
+// how many levels a full mip chain has, down to 1x1
+static GLint FullLevelCount(GLsizei width, GLsizei height)
+{
+    GLint count = 1;
+    for(GLsizei size = std::max(width, height); size > 1; size /= 2)
+        ++count;
+    return count;
+}
+
+TextureArray::TextureArray(GLsizei width,
+                           GLsizei height,
+                           Bitmap::Format format,
+                           GLsizei layerCount,
+                           bool mipmapped,
+                           GLint minFilter,
+                           GLint magFilter,
+                           GLint wrapMode,
+                           bool srgb) :
+    _width(width),
+    _height(height),
+    _format(format),
+    _layerCount(layerCount),
+    _usedLayerCount(0),
+    _minFilter(minFilter),
+    _magFilter(magFilter),
+    _wrapMode(wrapMode),
+    _srgb(srgb)
+{
+    _create(mipmapped);
+}
+
+TextureArray::TextureArray(const std::vector<Bitmap>& bitmaps,
+                           bool mipmapped,
+                           GLint minFilter,
+                           GLint magFilter,
+                           GLint wrapMode,
+                           bool srgb) :
+    _usedLayerCount(0),
+    _minFilter(minFilter),
+    _magFilter(magFilter),
+    _wrapMode(wrapMode),
+    _srgb(srgb)
+{
+    if(bitmaps.empty())
+        throw std::runtime_error("TextureArray needs at least one bitmap");
+    
+    _width = (GLsizei)bitmaps[0].width();
+    _height = (GLsizei)bitmaps[0].height();
+    _format = bitmaps[0].format();
+    _layerCount = (GLsizei)bitmaps.size();
+    _create(mipmapped);
+    
+    for(size_t i = 0; i < bitmaps.size(); ++i)
+        add(bitmaps[i]);
+}
+
+TextureArray::~TextureArray()
+{
+    glDeleteTextures(1, &_object);
+}
+
+GLint TextureArray::add(const BitmapView& bitmap)
+{
+    if(_usedLayerCount >= _layerCount)
+        throw std::runtime_error("Every layer of the TextureArray is already used");
+    if(bitmap.format() != _format)
+        throw std::runtime_error("Bitmap is not the same format as the TextureArray layers");
+    
+    GLint layer = _usedLayerCount;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, _object);
+    
+    bool sameSize = (bitmap.width() == (unsigned)_width && bitmap.height() == (unsigned)_height);
+    if(sameSize && _levelCount == 1){
+        //upload straight from the view, without copying
+        _uploadLevel(bitmap, layer, 0);
+    } else {
+        Bitmap level = sameSize ? Bitmap(bitmap) : Bitmap(bitmap).resized((unsigned)_width, (unsigned)_height, Bitmap::Filter_Lanczos, _srgb);
+        _uploadLevel(level, layer, 0);
+        for(GLint i = 1; i < _levelCount; ++i){
+            level = level.mipmap(Bitmap::Filter_Box, _srgb);
+            _uploadLevel(level, layer, i);
+        }
+    }
+    
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    ++_usedLayerCount;
+    return layer;
+}
+
+GLuint TextureArray::object() const
+{
+    return _object;
+}
+
+GLsizei TextureArray::width() const
+{
+    return _width;
+}
+
+GLsizei TextureArray::height() const
+{
+    return _height;
+}
+
+GLsizei TextureArray::layerCount() const
+{
+    return _layerCount;
+}
+
+GLsizei TextureArray::usedLayerCount() const
+{
+    return _usedLayerCount;
+}
+
+GLuint TextureArray::sampler(GLfloat anisotropy) const
+{
+    return SamplerCache::sampler(_minFilter, _magFilter, _wrapMode, anisotropy);
+}
+
+void TextureArray::_create(bool mipmapped)
+{
+    _levelCount = mipmapped ? FullLevelCount(_width, _height) : 1;
+    
+    //gray layers are stored in the red (and green) channels, which only look right
+    //if they can be swizzled. Otherwise fall back to luminance formats, like tdogl::Texture.
+    _sized = CanUseSizedFormat(_format);
+    GLenum internalFormat = _sized ? SizedFormatForBitmapFormat(_format, _srgb) : TextureFormatForBitmapFormat(_format, _srgb);
+    
+    glGenTextures(1, &_object);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, _object);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, _minFilter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, _magFilter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, _wrapMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, _wrapMode);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, _levelCount - 1);
+    
+    if(_sized && (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)){
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, _levelCount, internalFormat, _width, _height, _layerCount);
+    } else {
+        for(GLint level = 0; level < _levelCount; ++level){
+            glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                         level,
+                         internalFormat,
+                         std::max(1, _width >> level),
+                         std::max(1, _height >> level),
+                         _layerCount,
+                         0,
+                         PixelFormatForBitmapFormat(_format, _sized),
+                         GL_UNSIGNED_BYTE,
+                         NULL);
+        }
+    }
+    
+    if(_sized)
+        SetGraySwizzle(GL_TEXTURE_2D_ARRAY, _format);
+    
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::_uploadLevel(const BitmapView& bitmap, GLint layer, GLint level)
+{
+    //rows of bitmap pixels are tightly packed, not padded to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap.isContiguous() ? 0 : (GLint)(bitmap.rowStride() / bitmap.format()));
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                    level,
+                    0,
+                    0,
+                    layer,
+                    (GLsizei)bitmap.width(),
+                    (GLsizei)bitmap.height(),
+                    1,
+                    PixelFormatForBitmapFormat(bitmap.format(), _sized),
+                    GL_UNSIGNED_BYTE,
+                    bitmap.rowPointer(0));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
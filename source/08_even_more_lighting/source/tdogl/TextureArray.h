@@ -0,0 +1,144 @@
+/*
+ tdogl::TextureArray
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+#pragma once
+
+#include <GL/glew.h>
+#include "Bitmap.h"
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     Represents an OpenGL GL_TEXTURE_2D_ARRAY: a stack of same-sized images, called
+     layers, in a single texture object.
+
+     Assets with different images can all use one texture array, so they can be
+     drawn without binding a different texture for each one, e.g. in a single
+     instanced draw call. Shaders sample it with a `sampler2DArray`, using the layer
+     index as the third texture coordinate:
+
+         uniform sampler2DArray materialTex;
+         flat in int fragLayer;
+         ...
+         vec4 color = texture(materialTex, vec3(fragTexCoord, fragLayer));
+
+     Every layer has the same size and format. Images of a different size are
+     resized with tdogl::Bitmap::resized when they are added.
+     */
+    class TextureArray {
+    public:
+        /**
+         Creates an empty texture array with storage for `layerCount` layers. Fill
+         the layers in with `add`.
+
+         @param width  Width of every layer in pixels
+         @param height  Height of every layer in pixels
+         @param format  The format of every layer
+         @param layerCount  The most layers the array can hold
+         @param mipmapped  If true, every layer gets a full mip chain made with
+                           tdogl::Bitmap::mipmaps
+         @param minFilter  GL_NEAREST, GL_LINEAR, or one of the GL_*_MIPMAP_* filters
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         @param srgb  Whether the color channels are sRGB encoded
+         */
+        TextureArray(GLsizei width,
+                     GLsizei height,
+                     Bitmap::Format format,
+                     GLsizei layerCount,
+                     bool mipmapped = true,
+                     GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                     GLint magFilter = GL_LINEAR,
+                     GLint wrapMode = GL_REPEAT,
+                     bool srgb = true);
+
+        /**
+         Creates a texture array with one layer per bitmap. Layer `i` holds
+         `bitmaps[i]`. Every layer is the size of the first bitmap.
+
+         @throws std::exception if `bitmaps` is empty or the bitmaps aren't all the
+                 same format
+         */
+        TextureArray(const std::vector<Bitmap>& bitmaps,
+                     bool mipmapped = true,
+                     GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                     GLint magFilter = GL_LINEAR,
+                     GLint wrapMode = GL_REPEAT,
+                     bool srgb = true);
+
+        /**
+         Deletes the texture object with glDeleteTextures
+         */
+        ~TextureArray();
+
+        /**
+         Uploads an image into the next unused layer, resizing it first if it isn't
+         the same size as the layers.
+
+         @param bitmap  The image, which must be the same format as the layers
+         @result The index of the layer the image was put in, for use in shaders
+         @throws std::exception if every layer is already used, or the format is wrong
+         */
+        GLint add(const BitmapView& bitmap);
+
+        /**
+         @result The texture object, as created by glGenTextures
+         */
+        GLuint object() const;
+
+        /** width of every layer in pixels */
+        GLsizei width() const;
+
+        /** height of every layer in pixels */
+        GLsizei height() const;
+
+        /** the most layers the array can hold */
+        GLsizei layerCount() const;
+
+        /** how many layers have been filled in with `add` */
+        GLsizei usedLayerCount() const;
+
+        /**
+         The shared sampler object with this array's filter and wrap settings,
+         from tdogl::SamplerCache. See tdogl::Texture::sampler.
+         */
+        GLuint sampler(GLfloat anisotropy = 1.0f) const;
+
+    private:
+        GLuint _object;
+        GLsizei _width;
+        GLsizei _height;
+        Bitmap::Format _format;
+        GLsizei _layerCount;
+        GLsizei _usedLayerCount;
+        GLint _levelCount;
+        GLint _minFilter;
+        GLint _magFilter;
+        GLint _wrapMode;
+        bool _srgb;
+        bool _sized;
+
+        void _create(bool mipmapped);
+        void _uploadLevel(const BitmapView& bitmap, GLint layer, GLint level);
+
+        //copying disabled
+        TextureArray(const TextureArray&);
+        const TextureArray& operator=(const TextureArray&);
+    };
+
+}
@@ -0,0 +1,235 @@
+/*
+ tdogl::TextureAtlas
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace tdogl;
+
+namespace {
+    //one horizontal segment of the top edge of the packed area
+    struct SkylineNode {
+        unsigned x;
+        unsigned y;
+        unsigned width;
+    };
+    
+    struct PackingPage {
+        std::vector<SkylineNode> skyline;
+        unsigned usedHeight;
+    };
+    
+    struct Placement {
+        unsigned page;
+        unsigned x;
+        unsigned y;
+    };
+}
+
+static unsigned RoundUp(unsigned value, unsigned multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+//finds the lowest spot for a width x height rect, preferring the left on ties
+static bool FindSkylinePosition(const std::vector<SkylineNode>& skyline,
+                                unsigned pageSize,
+                                unsigned width,
+                                unsigned height,
+                                unsigned& bestIndex,
+                                unsigned& bestY)
+{
+    bool found = false;
+    for(unsigned i = 0; i < skyline.size(); ++i){
+        unsigned x = skyline[i].x;
+        if(x + width > pageSize)
+            break;
+        
+        //the rect sits on the highest node underneath it
+        unsigned y = 0;
+        unsigned covered = 0;
+        for(unsigned j = i; covered < width; ++j){
+            y = std::max(y, skyline[j].y);
+            covered += skyline[j].width;
+        }
+        
+        if(y + height <= pageSize && (!found || y + height < bestY + height)){
+            found = true;
+            bestIndex = i;
+            bestY = y;
+        }
+    }
+    return found;
+}
+
+static void AddSkylineRect(std::vector<SkylineNode>& skyline, unsigned index, unsigned y, unsigned width, unsigned height) {
+    SkylineNode node = { skyline[index].x, y + height, width };
+    skyline.insert(skyline.begin() + index, node);
+    
+    //shrink or remove the nodes now underneath the new one
+    unsigned right = node.x + node.width;
+    for(size_t i = index + 1; i < skyline.size(); ){
+        if(skyline[i].x >= right)
+            break;
+        unsigned nodeRight = skyline[i].x + skyline[i].width;
+        if(nodeRight <= right){
+            skyline.erase(skyline.begin() + i);
+        } else {
+            skyline[i].width = nodeRight - right;
+            skyline[i].x = right;
+            break;
+        }
+    }
+    
+    //merge neighbours at the same height
+    for(size_t i = 0; i + 1 < skyline.size(); ){
+        if(skyline[i].y == skyline[i + 1].y){
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
+
+//fills the area around an image with copies of its edge pixels
+static void ExtrudeEdges(Bitmap& page,
+                         unsigned blockX, unsigned blockY,
+                         unsigned blockWidth, unsigned blockHeight,
+                         unsigned imageX, unsigned imageY,
+                         unsigned imageWidth, unsigned imageHeight)
+{
+    //left and right, on the rows of the image
+    for(unsigned x = blockX; x < imageX; ++x)
+        page.view(x, imageY, 1, imageHeight).copyFrom(page.view(imageX, imageY, 1, imageHeight));
+    for(unsigned x = imageX + imageWidth; x < blockX + blockWidth; ++x)
+        page.view(x, imageY, 1, imageHeight).copyFrom(page.view(imageX + imageWidth - 1, imageY, 1, imageHeight));
+    
+    //then the top and bottom, which fills the corners too
+    for(unsigned y = blockY; y < imageY; ++y)
+        page.view(blockX, y, blockWidth, 1).copyFrom(page.view(blockX, imageY, blockWidth, 1));
+    for(unsigned y = imageY + imageHeight; y < blockY + blockHeight; ++y)
+        page.view(blockX, y, blockWidth, 1).copyFrom(page.view(blockX, imageY + imageHeight - 1, blockWidth, 1));
+}
+
+static bool IsPowerOfTwo(unsigned value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+
+/*
+ * TextureAtlas class
+ */
+
+glm::vec2 TextureAtlas::Region::remap(glm::vec2 uv) const {
+    return uvMin + uv * (uvMax - uvMin);
+}
+
+TextureAtlas::TextureAtlas(const std::vector<BitmapView>& bitmaps,
+                           unsigned pageSize,
+                           unsigned padding,
+                           unsigned alignment,
+                           Bitmap::Format format)
+{
+    if(!IsPowerOfTwo(alignment))
+        throw std::runtime_error("Texture atlas alignment must be a power of two");
+    if(pageSize % alignment != 0)
+        throw std::runtime_error("Texture atlas page size must be a multiple of the alignment");
+    
+    //pack the tallest images first, which wastes the least space
+    std::vector<unsigned> order(bitmaps.size());
+    for(unsigned i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        if(bitmaps[a].height() != bitmaps[b].height())
+            return bitmaps[a].height() > bitmaps[b].height();
+        return bitmaps[a].width() > bitmaps[b].width();
+    });
+    
+    std::vector<PackingPage> packingPages;
+    std::vector<Placement> placements(bitmaps.size());
+    for(unsigned i = 0; i < order.size(); ++i){
+        const BitmapView& bitmap = bitmaps[order[i]];
+        unsigned blockWidth = RoundUp(bitmap.width() + 2*padding, alignment);
+        unsigned blockHeight = RoundUp(bitmap.height() + 2*padding, alignment);
+        if(blockWidth > pageSize || blockHeight > pageSize)
+            throw std::runtime_error("Bitmap is too big for the texture atlas page size");
+        
+        unsigned page, index, y;
+        for(page = 0; page < packingPages.size(); ++page){
+            if(FindSkylinePosition(packingPages[page].skyline, pageSize, blockWidth, blockHeight, index, y))
+                break;
+        }
+        if(page == packingPages.size()){
+            SkylineNode node = { 0, 0, pageSize };
+            PackingPage newPage;
+            newPage.skyline.push_back(node);
+            newPage.usedHeight = 0;
+            packingPages.push_back(newPage);
+            FindSkylinePosition(packingPages[page].skyline, pageSize, blockWidth, blockHeight, index, y);
+        }
+        
+        PackingPage& packingPage = packingPages[page];
+        placements[order[i]].page = page;
+        placements[order[i]].x = packingPage.skyline[index].x;
+        placements[order[i]].y = y;
+        packingPage.usedHeight = std::max(packingPage.usedHeight, y + blockHeight);
+        AddSkylineRect(packingPage.skyline, index, y, blockWidth, blockHeight);
+    }
+    
+    //unused space is left transparent black
+    _pages.reserve(packingPages.size());
+    for(size_t i = 0; i < packingPages.size(); ++i){
+        _pages.push_back(Bitmap(pageSize, packingPages[i].usedHeight, format));
+        Bitmap& page = _pages.back();
+        memset(page.pixelBuffer(), 0, (size_t)page.width() * page.height() * page.format());
+    }
+    
+    _regions.resize(bitmaps.size());
+    for(size_t i = 0; i < bitmaps.size(); ++i){
+        const BitmapView& bitmap = bitmaps[i];
+        const Placement& placement = placements[i];
+        Bitmap& page = _pages[placement.page];
+        
+        Region& region = _regions[i];
+        region.page = placement.page;
+        region.x = placement.x + padding;
+        region.y = placement.y + padding;
+        region.width = bitmap.width();
+        region.height = bitmap.height();
+        region.uvMin = glm::vec2((float)region.x / page.width(), (float)region.y / page.height());
+        region.uvMax = glm::vec2((float)(region.x + region.width) / page.width(),
+                                 (float)(region.y + region.height) / page.height());
+        
+        page.view(region.x, region.y, region.width, region.height).copyFrom(bitmap);
+        ExtrudeEdges(page,
+                     placement.x, placement.y,
+                     RoundUp(bitmap.width() + 2*padding, alignment),
+                     RoundUp(bitmap.height() + 2*padding, alignment),
+                     region.x, region.y, region.width, region.height);
+    }
+}
+
+const std::vector<Bitmap>& TextureAtlas::pages() const {
+    return _pages;
+}
+
+const std::vector<TextureAtlas::Region>& TextureAtlas::regions() const {
+    return _regions;
+}
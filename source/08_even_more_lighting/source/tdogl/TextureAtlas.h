@@ -0,0 +1,95 @@
+/*
+ tdogl::TextureAtlas
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Bitmap.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace tdogl {
+    
+    /**
+     Packs many bitmaps into a few large bitmaps (pages), so that models using
+     different images can share one texture.
+     
+     Each bitmap is surrounded by a gutter of copies of its edge pixels, so that
+     linear filtering and mipmapping don't bleed neighbouring images into it. The
+     gutters are `padding` pixels wide, and every image is placed on a multiple of
+     `alignment` pixels, so box filtered mipmaps (see tdogl::Bitmap::mipmaps) keep
+     the images separate down to mip level log2(alignment).
+     
+     Images are packed with the skyline bottom-left algorithm, biggest first. A
+     new page is started whenever an image doesn't fit in the existing ones.
+     */
+    class TextureAtlas {
+    public:
+        /**
+         Where one of the source bitmaps ended up
+         */
+        struct Region {
+            unsigned page; /**< index into `pages()` */
+            unsigned x; /**< column of the top-left pixel of the image in the page, not including the gutter */
+            unsigned y; /**< row of the top-left pixel of the image in the page, not including the gutter */
+            unsigned width; /**< width of the image in pixels */
+            unsigned height; /**< height of the image in pixels */
+            glm::vec2 uvMin; /**< texture coordinate of the first pixel corner of the image */
+            glm::vec2 uvMax; /**< texture coordinate of the last pixel corner of the image */
+            
+            /**
+             Converts a texture coordinate for the original bitmap into a texture
+             coordinate for the page texture.
+             */
+            glm::vec2 remap(glm::vec2 uv) const;
+        };
+        
+        /**
+         Packs the bitmaps.
+         
+         The texture coordinates assume each page is uploaded with the same row order
+         as the source bitmaps, e.g. if the sources were flipped for OpenGL before
+         packing, the page is uploaded without flipping it again.
+         
+         @param bitmaps  The bitmaps to pack. Any format is accepted, and converted
+                         to `format`.
+         @param pageSize  The width and maximum height of each page. The last rows of
+                          a page are trimmed off if they aren't used.
+         @param padding  Width of the gutter around each image, in pixels
+         @param alignment  Images are placed on multiples of this many pixels. Must
+                           be a power of two.
+         @param format  The format of the pages
+         @throws std::exception if an image is too big to fit in a page
+         */
+        TextureAtlas(const std::vector<BitmapView>& bitmaps,
+                     unsigned pageSize = 2048,
+                     unsigned padding = 4,
+                     unsigned alignment = 4,
+                     Bitmap::Format format = Bitmap::Format_RGBA);
+        
+        /** The packed pages. Make a tdogl::Texture from each one. */
+        const std::vector<Bitmap>& pages() const;
+        
+        /** One region per source bitmap, in the same order as the bitmaps given to the constructor */
+        const std::vector<Region>& regions() const;
+        
+    private:
+        std::vector<Bitmap> _pages;
+        std::vector<Region> _regions;
+    };
+    
+}
@@ -0,0 +1,99 @@
+/*
+ tdogl::TextureCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureCache.h"
+#include "FileUtils.h"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace tdogl;
+
+//change this whenever the way cache files are made changes, so old ones get remade
+static const char kCacheVersion[] = "tdogl-texture-cache-1";
+
+TextureCache::TextureCache(const std::string& directory) :
+    _directory(directory)
+{
+    MakeDirectory(_directory);
+}
+
+std::unique_ptr<TextureFile> TextureCache::load(const std::string& imagePath, bool mipmaps) {
+    return _load(imagePath, false, CompressedBitmap::Format_BC1, mipmaps);
+}
+
+std::unique_ptr<TextureFile> TextureCache::load(const std::string& imagePath,
+                                                CompressedBitmap::Format format,
+                                                bool mipmaps)
+{
+    return _load(imagePath, true, format, mipmaps);
+}
+
+const std::string& TextureCache::directory() const {
+    return _directory;
+}
+
+std::unique_ptr<TextureFile> TextureCache::_load(const std::string& imagePath,
+                                                 bool compressed,
+                                                 CompressedBitmap::Format format,
+                                                 bool mipmaps)
+{
+    std::vector<unsigned char> contents = ReadFileContents(imagePath);
+    if(contents.empty())
+        throw std::runtime_error(std::string("Empty image file: ") + imagePath);
+
+    //the load limits change the decoded size, so they are part of the key too
+    char settings[128];
+    snprintf(settings, sizeof(settings), "%s/%d/%d/%d/%u/%llu", kCacheVersion, (int)compressed, (int)format, (int)mipmaps,
+             Bitmap::loadLimitDimension(), (unsigned long long)Bitmap::loadLimitBytes());
+    unsigned long long hash = HashBytes(&contents[0], contents.size());
+    hash = HashBytes(settings, strlen(settings), hash);
+
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.tdtex", hash);
+    std::string cachePath = _directory + "/" + fileName;
+
+    try {
+        return std::unique_ptr<TextureFile>(new TextureFile(cachePath));
+    } catch(const std::exception&) {
+        //not cached yet, or the cache file is unreadable. Make it again.
+    }
+
+    Bitmap bmp = Bitmap::bitmapFromMemory(&contents[0], contents.size(), true);
+    std::vector<Bitmap> levels;
+    if(mipmaps)
+        levels = bmp.mipmaps();
+
+    std::unique_ptr<TextureFile> file;
+    if(compressed){
+        std::vector<CompressedBitmap> compressedLevels;
+        for(size_t i = 0; i < levels.size(); ++i)
+            compressedLevels.push_back(CompressedBitmap::compress(levels[i], format));
+        file.reset(new TextureFile(CompressedBitmap::compress(bmp, format), compressedLevels));
+    } else {
+        file.reset(new TextureFile(bmp, levels));
+    }
+
+    try {
+        file->save(cachePath);
+    } catch(const std::exception&) {
+        //the cache directory isn't writable, so the image will be decoded again next time
+    }
+    return file;
+}
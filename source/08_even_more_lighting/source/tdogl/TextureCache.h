@@ -0,0 +1,77 @@
+/*
+ tdogl::TextureCache
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "TextureFile.h"
+#include <string>
+#include <memory>
+
+namespace tdogl {
+
+    /**
+     A directory of tdogl::TextureFile files made from image files.
+
+     The first time an image is loaded it is decoded, flipped, mipmapped and
+     optionally compressed, then saved into the cache directory. After that, loading
+     the same image just memory maps the saved file.
+
+     Cache files are named after a hash of the image file contents and the load
+     settings, so editing an image makes a new cache file instead of using a stale
+     one. Old cache files are never deleted, but the whole directory can safely be
+     deleted at any time.
+     */
+    class TextureCache {
+    public:
+        /**
+         @param directory  The directory to keep the cache files in. It is created if
+                           it doesn't exist.
+         */
+        explicit TextureCache(const std::string& directory);
+
+        /**
+         Loads an image file as an uncompressed texture file, from the cache if possible.
+
+         @param imagePath  The path to an image file that tdogl::Bitmap can load
+         @param mipmaps  If true, the texture file contains a full mip chain made with
+                         tdogl::Bitmap::mipmaps
+         @throws std::exception if the image file can't be read or decoded
+         */
+        std::unique_ptr<TextureFile> load(const std::string& imagePath, bool mipmaps = true);
+
+        /**
+         Same as the other `load`, except that every level is block compressed with
+         tdogl::CompressedBitmap::compress.
+         */
+        std::unique_ptr<TextureFile> load(const std::string& imagePath,
+                                          CompressedBitmap::Format format,
+                                          bool mipmaps = true);
+
+        /** the directory that the cache files are kept in */
+        const std::string& directory() const;
+
+    private:
+        std::string _directory;
+
+        std::unique_ptr<TextureFile> _load(const std::string& imagePath,
+                                           bool compressed,
+                                           CompressedBitmap::Format format,
+                                           bool mipmaps);
+    };
+
+}
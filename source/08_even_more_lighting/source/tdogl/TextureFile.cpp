@@ -0,0 +1,247 @@
+/*
+ tdogl::TextureFile
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureFile.h"
+#include "FileUtils.h"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+
+using namespace tdogl;
+
+static const char kMagic[4] = {'T', 'D', 'T', 'X'};
+static const unsigned kVersion = 1;
+static const size_t kHeaderSize = 32;
+static const size_t kLevelEntrySize = 24;
+static const size_t kDataAlignment = 16;
+
+enum HeaderFlags {
+    HeaderFlag_Compressed = 1,
+    HeaderFlag_SRGB = 2
+};
+
+
+/*
+ * Little endian helpers
+ */
+
+static void WriteU32(unsigned char* dest, unsigned value) {
+    for(unsigned i = 0; i < 4; ++i)
+        dest[i] = (unsigned char)(value >> (8*i));
+}
+
+static void WriteU64(unsigned char* dest, unsigned long long value) {
+    for(unsigned i = 0; i < 8; ++i)
+        dest[i] = (unsigned char)(value >> (8*i));
+}
+
+static unsigned ReadU32(const unsigned char* src) {
+    unsigned value = 0;
+    for(unsigned i = 0; i < 4; ++i)
+        value |= (unsigned)src[i] << (8*i);
+    return value;
+}
+
+static unsigned long long ReadU64(const unsigned char* src) {
+    unsigned long long value = 0;
+    for(unsigned i = 0; i < 8; ++i)
+        value |= (unsigned long long)src[i] << (8*i);
+    return value;
+}
+
+static size_t ExpectedLevelSize(bool compressed, unsigned format, unsigned width, unsigned height) {
+    if(compressed){
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4)
+            * CompressedBitmap::bytesPerBlock((CompressedBitmap::Format)format);
+    } else {
+        return (size_t)width * height * format;
+    }
+}
+
+
+/*
+ * TextureFile class
+ */
+
+TextureFile::TextureFile(const std::string& filePath) :
+    _bytes(NULL),
+    _size(0),
+    _file(new MappedFile(filePath))
+{
+    _bytes = _file->bytes();
+    _size = _file->size();
+    try {
+        _parse();
+    } catch(...) {
+        delete _file;
+        throw;
+    }
+}
+
+TextureFile::TextureFile(const Bitmap& bitmap, const std::vector<Bitmap>& mipmaps, bool srgb) :
+    _bytes(NULL),
+    _size(0),
+    _file(NULL)
+{
+    std::vector<const unsigned char*> data;
+    std::vector<Level> levels;
+    for(size_t i = 0; i <= mipmaps.size(); ++i){
+        const Bitmap& level = (i == 0) ? bitmap : mipmaps[i - 1];
+        if(level.format() != bitmap.format())
+            throw std::runtime_error("Mipmaps must have the same format as the base bitmap");
+        Level entry = { 0, ExpectedLevelSize(false, level.format(), level.width(), level.height()), level.width(), level.height() };
+        levels.push_back(entry);
+        data.push_back(level.pixelBuffer());
+    }
+    _build(false, bitmap.format(), srgb, data, levels);
+}
+
+TextureFile::TextureFile(const CompressedBitmap& image, const std::vector<CompressedBitmap>& mipmaps) :
+    _bytes(NULL),
+    _size(0),
+    _file(NULL)
+{
+    std::vector<const unsigned char*> data;
+    std::vector<Level> levels;
+    for(size_t i = 0; i <= mipmaps.size(); ++i){
+        const CompressedBitmap& level = (i == 0) ? image : mipmaps[i - 1];
+        if(level.format() != image.format() || level.isSRGB() != image.isSRGB())
+            throw std::runtime_error("Mipmaps must have the same format as the base image");
+        Level entry = { 0, level.dataSize(), level.width(), level.height() };
+        levels.push_back(entry);
+        data.push_back(level.data());
+    }
+    _build(true, image.format(), image.isSRGB(), data, levels);
+}
+
+TextureFile::~TextureFile() {
+    delete _file;
+}
+
+void TextureFile::save(const std::string& filePath) const {
+    FILE* f = CreateTempFile(filePath);
+    if(!f)
+        throw std::runtime_error(std::string("Failed to create texture file: ") + filePath);
+
+    bool ok = (fwrite(_bytes, 1, _size, f) == _size);
+    if(!FinishTempFile(f, filePath, ok))
+        throw std::runtime_error(std::string("Failed to write texture file: ") + filePath);
+}
+
+bool TextureFile::isCompressed() const {
+    return _compressed;
+}
+
+Bitmap::Format TextureFile::bitmapFormat() const {
+    return (Bitmap::Format)_format;
+}
+
+CompressedBitmap::Format TextureFile::compressedFormat() const {
+    return (CompressedBitmap::Format)_format;
+}
+
+bool TextureFile::isSRGB() const {
+    return _srgb;
+}
+
+unsigned TextureFile::levelCount() const {
+    return (unsigned)_levels.size();
+}
+
+unsigned TextureFile::levelWidth(unsigned level) const {
+    return _levels.at(level).width;
+}
+
+unsigned TextureFile::levelHeight(unsigned level) const {
+    return _levels.at(level).height;
+}
+
+const unsigned char* TextureFile::levelData(unsigned level) const {
+    return _bytes + _levels.at(level).offset;
+}
+
+size_t TextureFile::levelSize(unsigned level) const {
+    return (size_t)_levels.at(level).size;
+}
+
+void TextureFile::_build(bool compressed, unsigned format, bool srgb,
+                         const std::vector<const unsigned char*>& data,
+                         const std::vector<Level>& levels)
+{
+    size_t offset = kHeaderSize + levels.size() * kLevelEntrySize;
+    std::vector<Level> placed(levels);
+    for(size_t i = 0; i < placed.size(); ++i){
+        offset = (offset + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+        placed[i].offset = offset;
+        offset += (size_t)placed[i].size;
+    }
+
+    _ownedBytes.assign(offset, 0);
+    unsigned char* bytes = &_ownedBytes[0];
+    memcpy(bytes, kMagic, 4);
+    WriteU32(bytes + 4, kVersion);
+    WriteU32(bytes + 8, (compressed ? HeaderFlag_Compressed : 0) | (srgb ? HeaderFlag_SRGB : 0));
+    WriteU32(bytes + 12, format);
+    WriteU32(bytes + 16, (unsigned)placed.size());
+    for(size_t i = 0; i < placed.size(); ++i){
+        unsigned char* entry = bytes + kHeaderSize + i * kLevelEntrySize;
+        WriteU64(entry, placed[i].offset);
+        WriteU64(entry + 8, placed[i].size);
+        WriteU32(entry + 16, placed[i].width);
+        WriteU32(entry + 20, placed[i].height);
+        memcpy(bytes + placed[i].offset, data[i], (size_t)placed[i].size);
+    }
+
+    _bytes = bytes;
+    _size = _ownedBytes.size();
+    _parse();
+}
+
+void TextureFile::_parse() {
+    if(_size < kHeaderSize || memcmp(_bytes, kMagic, 4) != 0)
+        throw std::runtime_error("Not a texture file");
+    if(ReadU32(_bytes + 4) != kVersion)
+        throw std::runtime_error("Unsupported texture file version");
+
+    unsigned flags = ReadU32(_bytes + 8);
+    _compressed = (flags & HeaderFlag_Compressed) != 0;
+    _srgb = (flags & HeaderFlag_SRGB) != 0;
+    _format = ReadU32(_bytes + 12);
+    if(_compressed ? (_format > CompressedBitmap::Format_ETC2_RGB) : (_format < 1 || _format > 4))
+        throw std::runtime_error("Texture file has an invalid format");
+
+    unsigned count = ReadU32(_bytes + 16);
+    if(count == 0 || count > 32 || _size < kHeaderSize + count * kLevelEntrySize)
+        throw std::runtime_error("Texture file has an invalid level table");
+
+    _levels.resize(count);
+    for(unsigned i = 0; i < count; ++i){
+        const unsigned char* entry = _bytes + kHeaderSize + i * kLevelEntrySize;
+        Level& level = _levels[i];
+        level.offset = ReadU64(entry);
+        level.size = ReadU64(entry + 8);
+        level.width = ReadU32(entry + 16);
+        level.height = ReadU32(entry + 20);
+        if(level.width == 0 || level.height == 0
+           || level.size != ExpectedLevelSize(_compressed, _format, level.width, level.height)
+           || level.offset > _size || level.size > _size - level.offset)
+        {
+            throw std::runtime_error("Texture file is truncated or corrupt");
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ tdogl::TextureFile
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Bitmap.h"
+#include "CompressedBitmap.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A texture file containing pixel data that is ready to upload to OpenGL.
+
+     The file holds the format, the size, and every mip level of a texture, stored
+     exactly as glTexImage2D or glCompressedTexImage2D expects them (bottom row first
+     for uncompressed data, i.e. already flipped). Loading one is a memory map and a
+     header check, with no decoding or conversion.
+
+     The layout is a fixed header, then a table with the offset, size and dimensions
+     of each level, then the level data, each level starting on a 16 byte boundary.
+     All numbers are little endian.
+
+     Use tdogl::Texture to upload one, or tdogl::TextureCache to make them
+     automatically from image files.
+     */
+    class TextureFile {
+    public:
+        /**
+         Memory maps an existing texture file.
+
+         @throws std::exception if the file can't be opened or isn't a valid texture file
+         */
+        explicit TextureFile(const std::string& filePath);
+
+        /**
+         Makes a texture file in memory from uncompressed bitmaps. Nothing is written to
+         disk until `save` is called.
+
+         @param bitmap  Mip level 0, with the rows already in OpenGL order
+         @param mipmaps  Mip levels 1 and up. May be empty.
+         @param srgb  Whether the color channels are sRGB encoded
+         */
+        TextureFile(const Bitmap& bitmap, const std::vector<Bitmap>& mipmaps, bool srgb = true);
+
+        /**
+         Makes a texture file in memory from block compressed images. Nothing is written
+         to disk until `save` is called.
+         */
+        TextureFile(const CompressedBitmap& image, const std::vector<CompressedBitmap>& mipmaps);
+
+        /** Unmaps the file, which invalidates all pointers returned from `levelData` */
+        ~TextureFile();
+
+        /**
+         Writes the file to disk. Writes to a temporary file and then renames it, so
+         other processes never see a half written file.
+
+         @throws std::exception if the file can't be written
+         */
+        void save(const std::string& filePath) const;
+
+        /** true if the levels are block compressed */
+        bool isCompressed() const;
+
+        /** the format of the levels. Only valid if `isCompressed` is false */
+        Bitmap::Format bitmapFormat() const;
+
+        /** the format of the levels. Only valid if `isCompressed` is true */
+        CompressedBitmap::Format compressedFormat() const;
+
+        /** whether the color channels are sRGB encoded */
+        bool isSRGB() const;
+
+        /** the number of mip levels, including level 0 */
+        unsigned levelCount() const;
+
+        /** width in pixels of the given mip level */
+        unsigned levelWidth(unsigned level) const;
+
+        /** height in pixels of the given mip level */
+        unsigned levelHeight(unsigned level) const;
+
+        /** pointer to the pixel data of the given mip level, which points into the mapped file */
+        const unsigned char* levelData(unsigned level) const;
+
+        /** size in bytes of the pixel data of the given mip level */
+        size_t levelSize(unsigned level) const;
+
+    private:
+        struct Level {
+            unsigned long long offset;
+            unsigned long long size;
+            unsigned width;
+            unsigned height;
+        };
+
+        const unsigned char* _bytes;
+        size_t _size;
+        std::vector<unsigned char> _ownedBytes;
+        MappedFile* _file;
+        bool _compressed;
+        unsigned _format;
+        bool _srgb;
+        std::vector<Level> _levels;
+
+        void _build(bool compressed, unsigned format, bool srgb,
+                    const std::vector<const unsigned char*>& data,
+                    const std::vector<Level>& levels);
+        void _parse();
+
+        //copying disabled
+        TextureFile(const TextureFile&);
+        const TextureFile& operator=(const TextureFile&);
+    };
+
+}
@@ -0,0 +1,75 @@
+/*
+ tdogl texture format helpers
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureFormats.h"
+#include <stdexcept>
+
+using namespace tdogl;
+
+static bool IsGray(Bitmap::Format format)
+{
+    return format == Bitmap::Format_Grayscale || format == Bitmap::Format_GrayscaleAlpha;
+}
+
+GLenum tdogl::TextureFormatForBitmapFormat(Bitmap::Format format, bool srgb)
+{
+    switch (format) {
+        case Bitmap::Format_Grayscale: return GL_LUMINANCE;
+        case Bitmap::Format_GrayscaleAlpha: return GL_LUMINANCE_ALPHA;
+        case Bitmap::Format_RGB: return (srgb ? GL_SRGB : GL_RGB);
+        case Bitmap::Format_RGBA: return (srgb ? GL_SRGB_ALPHA : GL_RGBA);
+        default: throw std::runtime_error("Unrecognised Bitmap::Format");
+    }
+}
+
+GLenum tdogl::SizedFormatForBitmapFormat(Bitmap::Format format, bool srgb)
+{
+    switch (format) {
+        case Bitmap::Format_Grayscale: return GL_R8;
+        case Bitmap::Format_GrayscaleAlpha: return GL_RG8;
+        case Bitmap::Format_RGB: return (srgb ? GL_SRGB8 : GL_RGB8);
+        case Bitmap::Format_RGBA: return (srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8);
+        default: throw std::runtime_error("Unrecognised Bitmap::Format");
+    }
+}
+
+GLenum tdogl::PixelFormatForBitmapFormat(Bitmap::Format format, bool sized)
+{
+    if(!sized)
+        return TextureFormatForBitmapFormat(format, false);
+    switch (format) {
+        case Bitmap::Format_Grayscale: return GL_RED;
+        case Bitmap::Format_GrayscaleAlpha: return GL_RG;
+        case Bitmap::Format_RGB: return GL_RGB;
+        case Bitmap::Format_RGBA: return GL_RGBA;
+        default: throw std::runtime_error("Unrecognised Bitmap::Format");
+    }
+}
+
+bool tdogl::CanUseSizedFormat(Bitmap::Format format)
+{
+    return !IsGray(format) || GLEW_VERSION_3_3 || GLEW_ARB_texture_swizzle;
+}
+
+void tdogl::SetGraySwizzle(GLenum target, Bitmap::Format format)
+{
+    if(!IsGray(format))
+        return;
+    GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, (format == Bitmap::Format_Grayscale) ? GL_ONE : GL_GREEN };
+    glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
@@ -0,0 +1,63 @@
+/*
+ tdogl texture format helpers
+ 
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+ 
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ 
+ http://www.apache.org/licenses/LICENSE-2.0
+ 
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <GL/glew.h>
+#include "Bitmap.h"
+
+namespace tdogl {
+    
+    /**
+     The unsized internal format for a bitmap format, for glTexImage* when sized
+     formats can't be used. Gray bitmaps become GL_LUMINANCE textures.
+     */
+    GLenum TextureFormatForBitmapFormat(Bitmap::Format format, bool srgb);
+    
+    /**
+     The sized internal format for a bitmap format, for glTexStorage* and
+     glTexImage*. One and two channel bitmaps become red and red-green textures,
+     which SetGraySwizzle turns back into gray and alpha.
+     */
+    GLenum SizedFormatForBitmapFormat(Bitmap::Format format, bool srgb);
+    
+    /**
+     The format of the pixel data passed to glTexSubImage*.
+     
+     @param sized  true if the texture was made with SizedFormatForBitmapFormat,
+                   false if it was made with TextureFormatForBitmapFormat
+     */
+    GLenum PixelFormatForBitmapFormat(Bitmap::Format format, bool sized);
+    
+    /**
+     @result true if textures of this format can use SizedFormatForBitmapFormat.
+             Always true for color bitmaps. Gray bitmaps need texture swizzling
+             (OpenGL 3.3 or ARB_texture_swizzle), or they would show up red.
+     */
+    bool CanUseSizedFormat(Bitmap::Format format);
+    
+    /**
+     Swizzles the red (and green) channels of a gray texture made with
+     SizedFormatForBitmapFormat, so shaders read gray and alpha like they do from
+     a GL_LUMINANCE texture. Does nothing for color formats.
+     
+     @param target  The binding point of the texture, e.g. GL_TEXTURE_2D
+     */
+    void SetGraySwizzle(GLenum target, Bitmap::Format format);
+    
+}
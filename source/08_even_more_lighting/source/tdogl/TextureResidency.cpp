@@ -0,0 +1,145 @@
+/*
+ tdogl::TextureResidency
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureResidency.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace tdogl;
+
+//textures are never shrunk below this many pixels wide or high, unless they're released completely
+static const unsigned kMinShrunkSize = 64;
+
+// total size of the levels in the file, starting at `firstLevel`
+static size_t FileSizeFromLevel(const TextureFile& file, unsigned firstLevel) {
+    size_t size = 0;
+    for(unsigned i = firstLevel; i < file.levelCount(); ++i)
+        size += file.levelSize(i);
+    return size;
+}
+
+// the smallest level that is still at least kMinShrunkSize in either dimension
+static unsigned SmallestShrunkLevel(const TextureFile& file) {
+    unsigned level = 0;
+    while(level + 1 < file.levelCount() &&
+          std::max(file.levelWidth(level + 1), file.levelHeight(level + 1)) >= kMinShrunkSize)
+    {
+        ++level;
+    }
+    return level;
+}
+
+TextureResidency::TextureResidency(size_t budget) :
+    _budget(budget),
+    _frame(0)
+{
+}
+
+void TextureResidency::add(Texture* texture, std::unique_ptr<TextureFile> source) {
+    Entry& entry = _entries[texture];
+    entry.source = std::move(source);
+    entry.firstLevel = 0;
+    entry.released = false;
+    entry.lastUsedFrame = _frame;
+}
+
+void TextureResidency::remove(Texture* texture) {
+    _entries.erase(texture);
+}
+
+void TextureResidency::use(Texture* texture) {
+    std::map<Texture*, Entry>::iterator found = _entries.find(texture);
+    if(found == _entries.end())
+        throw std::runtime_error("Texture is not tracked by this TextureResidency");
+
+    Entry& entry = found->second;
+    entry.lastUsedFrame = _frame;
+    if(entry.released || entry.firstLevel > 0){
+        texture->_release();
+        texture->_uploadFile(*entry.source, 0);
+        entry.firstLevel = 0;
+        entry.released = false;
+    }
+}
+
+void TextureResidency::beginFrame() {
+    size_t resident = residentSize();
+    if(resident > _budget){
+        //oldest first. Textures used in the frame that just finished are left alone
+        std::vector<std::pair<unsigned long long, Texture*> > candidates;
+        std::map<Texture*, Entry>::iterator it;
+        for(it = _entries.begin(); it != _entries.end(); ++it){
+            const Entry& entry = it->second;
+            Texture* texture = it->first;
+            if(entry.source && !entry.released && entry.lastUsedFrame < _frame && texture->isReady() && !texture->_streaming)
+                candidates.push_back(std::make_pair(entry.lastUsedFrame, texture));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        //shrink textures before releasing any, so recently used ones can stay partly resident
+        for(size_t i = 0; i < candidates.size() && resident > _budget; ++i){
+            Texture* texture = candidates[i].second;
+            Entry& entry = _entries[texture];
+            const TextureFile& file = *entry.source;
+            size_t current = texture->videoMemorySize();
+            size_t others = resident - current;
+
+            //the texture's size scales with the size of the levels in the file
+            unsigned smallestLevel = SmallestShrunkLevel(file);
+            unsigned level = entry.firstLevel;
+            size_t estimate = current;
+            while(others + estimate > _budget && level < smallestLevel){
+                ++level;
+                estimate = (size_t)((double)current * FileSizeFromLevel(file, level) / FileSizeFromLevel(file, entry.firstLevel));
+            }
+            if(level == entry.firstLevel)
+                continue;
+
+            texture->_release();
+            texture->_uploadFile(file, level);
+            entry.firstLevel = level;
+            resident = others + texture->videoMemorySize();
+        }
+
+        for(size_t i = 0; i < candidates.size() && resident > _budget; ++i){
+            Texture* texture = candidates[i].second;
+            resident -= texture->videoMemorySize();
+            texture->_release();
+            _entries[texture].released = true;
+        }
+    }
+
+    ++_frame;
+}
+
+void TextureResidency::setBudget(size_t budget) {
+    _budget = budget;
+}
+
+size_t TextureResidency::budget() const {
+    return _budget;
+}
+
+size_t TextureResidency::residentSize() const {
+    size_t size = 0;
+    std::map<Texture*, Entry>::const_iterator it;
+    for(it = _entries.begin(); it != _entries.end(); ++it)
+        size += it->first->videoMemorySize();
+    return size;
+}
@@ -0,0 +1,123 @@
+/*
+ tdogl::TextureResidency
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+#pragma once
+
+#include "Texture.h"
+#include "TextureFile.h"
+#include <map>
+#include <memory>
+
+namespace tdogl {
+
+    /**
+     Keeps the video memory used by textures under a budget.
+
+     Each texture is registered along with the tdogl::TextureFile it was made
+     from. Once per frame, `beginFrame` checks the total size of the textures and,
+     if it's over the budget, shrinks the least recently used ones. First the top
+     mip levels are dropped, which frees three quarters of a texture per level, and
+     if that isn't enough the texture is released completely. Textures that were
+     drawn in the previous frame are never shrunk.
+
+     `use` must be called before drawing with a texture. If the texture was shrunk,
+     it is uploaded again in full from its file, which is still memory mapped, so
+     restoring a texture doesn't decode anything.
+
+     Only use this on the thread that owns the OpenGL context.
+
+     Example:
+
+         TextureResidency residency(256 * 1024 * 1024);
+         residency.add(texture, std::move(file));
+
+         //each frame
+         residency.beginFrame();
+         for(each visible instance){
+             residency.use(instance.texture);
+             glBindTexture(GL_TEXTURE_2D, instance.texture->object());
+             ...
+         }
+     */
+    class TextureResidency {
+    public:
+        /**
+         @param budget  The most video memory, in bytes, that the registered textures
+                        should use
+         */
+        explicit TextureResidency(size_t budget);
+
+        /**
+         Starts tracking a texture. The texture must have been made from `source`,
+         either with the tdogl::TextureFile constructor or by tdogl::TextureStreamer,
+         and must outlive this object or be removed with `remove` before it's
+         deleted. Textures are never shrunk while they are still streaming.
+
+         @param texture  The texture to track
+         @param source  The file the texture was made from, which is kept so the
+                        texture can be restored. If NULL, the texture counts towards
+                        the budget but is never shrunk.
+         */
+        void add(Texture* texture, std::unique_ptr<TextureFile> source);
+
+        /**
+         Stops tracking a texture and closes its source file. The texture is left as
+         it is, so it may still be shrunk.
+         */
+        void remove(Texture* texture);
+
+        /**
+         Marks a texture as used in the current frame, restoring it in full first if
+         it was shrunk. Call this before drawing with the texture, because
+         tdogl::Texture::object changes when a texture is shrunk or restored.
+         */
+        void use(Texture* texture);
+
+        /**
+         Shrinks the least recently used textures until the total is under the
+         budget, or until only the textures used in the previous frame are left.
+         Call this once per frame, before any calls to `use`.
+         */
+        void beginFrame();
+
+        /** sets the budget in bytes. Takes effect at the next `beginFrame` */
+        void setBudget(size_t budget);
+
+        /** the budget in bytes */
+        size_t budget() const;
+
+        /** the estimated total video memory used by the tracked textures, in bytes */
+        size_t residentSize() const;
+
+    private:
+        struct Entry {
+            std::unique_ptr<TextureFile> source;
+            unsigned firstLevel;
+            bool released;
+            unsigned long long lastUsedFrame;
+        };
+
+        std::map<Texture*, Entry> _entries;
+        size_t _budget;
+        unsigned long long _frame;
+
+        //copying disabled
+        TextureResidency(const TextureResidency&);
+        const TextureResidency& operator=(const TextureResidency&);
+    };
+
+}
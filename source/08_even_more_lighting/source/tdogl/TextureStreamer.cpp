@@ -0,0 +1,118 @@
+/*
+ tdogl::TextureStreamer
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace tdogl;
+
+// a view of the given rows of a level in the file, without copying
+static BitmapView LevelRows(const TextureFile& file, unsigned level, unsigned firstRow, unsigned rowCount) {
+    size_t rowSize = (size_t)file.levelWidth(level) * file.bitmapFormat();
+    unsigned char* pixels = const_cast<unsigned char*>(file.levelData(level)) + firstRow * rowSize;
+    return BitmapView(pixels, file.levelWidth(level), rowCount, file.bitmapFormat());
+}
+
+TextureStreamer::TextureStreamer(size_t bytesPerFrame, unsigned initialSize) :
+    _bytesPerFrame(bytesPerFrame),
+    _initialSize(initialSize)
+{
+}
+
+Texture* TextureStreamer::stream(const TextureFile& file, GLint minFilter, GLint magFilter, GLint wrapMode) {
+    if(file.isCompressed())
+        throw std::runtime_error("Compressed texture files can't be streamed");
+
+    Texture* texture = new Texture((GLsizei)file.levelWidth(0),
+                                   (GLsizei)file.levelHeight(0),
+                                   file.bitmapFormat(),
+                                   (GLint)file.levelCount(),
+                                   minFilter,
+                                   magFilter,
+                                   wrapMode,
+                                   file.isSRGB());
+
+    //upload the small levels now, so the texture is complete, always including the smallest
+    unsigned level = file.levelCount() - 1;
+    texture->update(LevelRows(file, level, 0, file.levelHeight(level)), 0, 0, (GLint)level);
+    while(level > 0 && std::max(file.levelWidth(level - 1), file.levelHeight(level - 1)) <= _initialSize){
+        --level;
+        texture->update(LevelRows(file, level, 0, file.levelHeight(level)), 0, 0, (GLint)level);
+    }
+    texture->_setBaseLevel((GLint)level);
+
+    if(level > 0){
+        Stream stream = { texture, &file, level - 1, 0 };
+        _streams.push_back(stream);
+        texture->_streaming = true;
+    }
+    return texture;
+}
+
+void TextureStreamer::beginFrame() {
+    size_t budget = _bytesPerFrame;
+    while(!_streams.empty() && budget > 0){
+        //the texture with the smallest next level goes first
+        size_t next = 0;
+        for(size_t i = 1; i < _streams.size(); ++i){
+            if(_streams[i].file->levelSize(_streams[i].level) < _streams[next].file->levelSize(_streams[next].level))
+                next = i;
+        }
+
+        Stream& stream = _streams[next];
+        const TextureFile& file = *stream.file;
+        unsigned height = file.levelHeight(stream.level);
+        size_t rowSize = (size_t)file.levelWidth(stream.level) * file.bitmapFormat();
+
+        //always upload at least one row, so streaming finishes even if a row is bigger than the budget
+        unsigned rowCount = (unsigned)std::min((size_t)(height - stream.nextRow), std::max((size_t)1, budget / rowSize));
+        stream.texture->update(LevelRows(file, stream.level, stream.nextRow, rowCount), 0, (GLint)stream.nextRow, (GLint)stream.level);
+        stream.nextRow += rowCount;
+        budget -= std::min(budget, rowCount * rowSize);
+
+        if(stream.nextRow == height){
+            stream.texture->_setBaseLevel((GLint)stream.level);
+            if(stream.level == 0){
+                stream.texture->_streaming = false;
+                _streams.erase(_streams.begin() + next);
+            } else {
+                --stream.level;
+                stream.nextRow = 0;
+            }
+        }
+    }
+}
+
+void TextureStreamer::cancel(Texture* texture) {
+    for(size_t i = 0; i < _streams.size(); ++i){
+        if(_streams[i].texture == texture){
+            texture->_streaming = false;
+            _streams.erase(_streams.begin() + i);
+            return;
+        }
+    }
+}
+
+bool TextureStreamer::isStreaming(const Texture* texture) const {
+    return texture->_streaming;
+}
+
+size_t TextureStreamer::streamingCount() const {
+    return _streams.size();
+}
@@ -0,0 +1,115 @@
+/*
+ tdogl::TextureStreamer
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+#pragma once
+
+#include <GL/glew.h>
+#include "Texture.h"
+#include "TextureFile.h"
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     Makes textures that can be drawn straight away, at low resolution, and then
+     sharpen over the next few frames.
+
+     `stream` creates storage for every mip level of a tdogl::TextureFile, but only
+     uploads the tiny levels at the end of the mip chain. GL_TEXTURE_BASE_LEVEL is
+     set to the largest level uploaded so far, so the texture is complete and can be
+     drawn immediately. Each call to `beginFrame` uploads more of the larger levels,
+     up to a per frame budget, and lowers the base level every time a level is
+     finished. Levels that don't fit in one frame's budget are uploaded a strip of
+     rows at a time.
+
+     Textures with the smallest next level go first, so every streaming texture
+     gets sharper at about the same rate.
+
+     Only uncompressed texture files can be streamed. Only use this on the thread
+     that owns the OpenGL context.
+
+     Example:
+
+         std::unique_ptr<TextureFile> file = cache.load("image.png");
+         Texture* texture = streamer.stream(*file);
+
+         //each frame
+         streamer.beginFrame();
+         glBindTexture(GL_TEXTURE_2D, texture->object());
+     */
+    class TextureStreamer {
+    public:
+        /**
+         @param bytesPerFrame  The most pixel data to upload in each call to `beginFrame`
+         @param initialSize  Levels this many pixels wide and high, or smaller, are
+                             uploaded by `stream` before it returns
+         */
+        TextureStreamer(size_t bytesPerFrame = 4 * 1024 * 1024, unsigned initialSize = 16);
+
+        /**
+         Makes a texture from a texture file, uploading only the smallest levels.
+
+         @param file  The file to stream from. It must stay alive until the texture
+                      has finished streaming, or the texture is passed to `cancel`.
+         @param minFilter  One of the GL_*_MIPMAP_* filters, GL_NEAREST or GL_LINEAR
+         @param magFilter  GL_NEAREST or GL_LINEAR
+         @param wrapMode GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE, or GL_CLAMP_TO_BORDER
+         @result A new texture that can be drawn immediately. The caller owns it, and
+                 must call `cancel` before deleting it if it's still streaming.
+         @throws std::exception if the file is block compressed
+         */
+        Texture* stream(const TextureFile& file,
+                        GLint minFilter = GL_LINEAR_MIPMAP_LINEAR,
+                        GLint magFilter = GL_LINEAR,
+                        GLint wrapMode = GL_CLAMP_TO_EDGE);
+
+        /**
+         Uploads more levels of the streaming textures, up to `bytesPerFrame`.
+         Call this once per frame.
+         */
+        void beginFrame();
+
+        /**
+         Stops streaming a texture, leaving it at whatever resolution it has reached.
+         Does nothing if the texture isn't streaming.
+         */
+        void cancel(Texture* texture);
+
+        /** true until every level of the texture has been uploaded */
+        bool isStreaming(const Texture* texture) const;
+
+        /** how many textures are still streaming */
+        size_t streamingCount() const;
+
+    private:
+        struct Stream {
+            Texture* texture;
+            const TextureFile* file;
+            unsigned level;
+            unsigned nextRow;
+        };
+
+        std::vector<Stream> _streams;
+        size_t _bytesPerFrame;
+        unsigned _initialSize;
+
+        //copying disabled
+        TextureStreamer(const TextureStreamer&);
+        const TextureStreamer& operator=(const TextureStreamer&);
+    };
+
+}
@@ -0,0 +1,177 @@
+/*
+ tdogl::TextureUploader
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TextureUploader.h"
+#include "PixelAllocator.h"
+#include <stdexcept>
+#include <cstring>
+
+using namespace tdogl;
+
+TextureUploader::TextureUploader(size_t bytesPerFrame, unsigned bufferCount) :
+    _bufferSize(bytesPerFrame),
+    _current(0),
+    _mapped(NULL),
+    _used(0),
+    _copiesInProgress(0)
+{
+    if(bytesPerFrame == 0 || bufferCount == 0)
+        throw std::runtime_error("TextureUploader needs at least one non-empty staging buffer");
+
+    _buffers.resize(bufferCount);
+    for(size_t i = 0; i < _buffers.size(); ++i){
+        glGenBuffers(1, &_buffers[i].object);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffers[i].object);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)_bufferSize, NULL, GL_STREAM_DRAW);
+        _buffers[i].fence = NULL;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    _mapCurrent();
+}
+
+TextureUploader::~TextureUploader() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(_copiesInProgress > 0)
+        _copiesDone.wait(lock);
+
+    for(size_t i = 0; i < _staged.size(); ++i)
+        --_staged[i].texture->_pendingUploads;
+
+    if(_mapped){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffers[_current].object);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    for(size_t i = 0; i < _buffers.size(); ++i){
+        if(_buffers[i].fence)
+            glDeleteSync(_buffers[i].fence);
+        glDeleteBuffers(1, &_buffers[i].object);
+    }
+}
+
+bool TextureUploader::stage(Texture& texture, const BitmapView& pixels, GLint x, GLint y, GLint level) {
+    texture._checkFormat(pixels);
+    size_t rowSize = (size_t)pixels.width() * pixels.format();
+    size_t size = rowSize * pixels.height();
+    if(size > _bufferSize)
+        throw std::runtime_error("Pixels are too big to fit in a texture staging buffer");
+    if(size == 0)
+        return true;
+
+    unsigned char* dest;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t offset = (_used + PixelAlignment - 1) / PixelAlignment * PixelAlignment;
+        if(!_mapped || offset + size > _bufferSize)
+            return false;
+
+        StagedUpload upload = { &texture, offset, (GLsizei)pixels.width(), (GLsizei)pixels.height(), x, y, level };
+        _staged.push_back(upload);
+        _used = offset + size;
+        ++_copiesInProgress;
+        ++texture._pendingUploads;
+        dest = _mapped + offset;
+    }
+
+    //copy outside the lock, so that several threads can stage at once. The rows
+    //are packed together, whatever the row stride of the view is.
+    for(unsigned row = 0; row < pixels.height(); ++row)
+        memcpy(dest + row * rowSize, pixels.rowPointer(row), rowSize);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(--_copiesInProgress == 0)
+        _copiesDone.notify_all();
+    return true;
+}
+
+void TextureUploader::beginFrame() {
+    std::vector<StagedUpload> staged;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        //keep filling the same buffer if nothing has been staged yet
+        if(_mapped && _staged.empty())
+            return;
+
+        while(_copiesInProgress > 0)
+            _copiesDone.wait(lock);
+        staged.swap(_staged);
+        _mapped = NULL;
+        _used = 0;
+    }
+
+    if(!staged.empty())
+        _issueStaged(staged);
+    _mapCurrent();
+}
+
+void TextureUploader::_issueStaged(std::vector<StagedUpload>& staged) {
+    Buffer& buffer = _buffers[_current];
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.object);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    //rows were packed together by `stage`
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(size_t i = 0; i < staged.size(); ++i){
+        const StagedUpload& upload = staged[i];
+        upload.texture->_updateFromBuffer(upload.offset, upload.width, upload.height,
+                                          upload.x, upload.y, upload.level);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    //the buffer can't be written again until the GPU has copied out of it. Each
+    //texture gets its own fence too, because textures are deleted independently.
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    for(size_t i = 0; i < staged.size(); ++i){
+        Texture& texture = *staged[i].texture;
+        //uploads into the same texture are usually staged together, and only need one fence
+        bool lastInRun = (i + 1 == staged.size() || staged[i + 1].texture != &texture);
+        if(lastInRun){
+            if(texture._uploadFence)
+                glDeleteSync(texture._uploadFence);
+            texture._uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        --texture._pendingUploads;
+    }
+
+    //start the copies now, instead of when the frame is finished
+    glFlush();
+    _current = (_current + 1) % (unsigned)_buffers.size();
+}
+
+void TextureUploader::_mapCurrent() {
+    Buffer& buffer = _buffers[_current];
+    if(buffer.fence){
+        //the GPU could still be copying out of this buffer from a few frames ago
+        if(glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(buffer.fence);
+        buffer.fence = NULL;
+    }
+
+    //the fence says the buffer is finished with, so there's no need for the driver to synchronise
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.object);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)_bufferSize,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(!mapped)
+        throw std::runtime_error("Failed to map a texture staging buffer");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _mapped = (unsigned char*)mapped;
+}
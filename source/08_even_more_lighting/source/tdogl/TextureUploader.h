@@ -0,0 +1,137 @@
+/*
+ tdogl::TextureUploader
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include <GL/glew.h>
+#include "Texture.h"
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     Uploads pixels into textures in the background, so loading textures while the
+     app is running doesn't make frames stutter.
+
+     Pixels are copied into a GL_PIXEL_UNPACK_BUFFER that is mapped into memory,
+     which any thread can do, e.g. an image decoding thread can stage its results
+     directly. Once per frame, `beginFrame` issues the staged uploads with
+     glTexSubImage2D from the buffer. OpenGL copies from the buffer in the
+     background, and a fence tells tdogl::Texture::isReady when it's done.
+
+     There is a ring of staging buffers, each the size of the per frame budget, so
+     new pixels can be staged while the GPU is still copying out of older buffers.
+     The uploader never waits for the GPU. If every buffer is still busy, `stage`
+     fails until one is free again.
+
+     Example:
+
+         //during loading, on any thread
+         while(!uploader.stage(*texture, bitmap))
+             waitForNextFrame();
+
+         //at the start of each frame, on the OpenGL thread
+         uploader.beginFrame();
+         if(texture->isReady())
+             drawWith(texture);
+     */
+    class TextureUploader {
+    public:
+        /**
+         Makes the staging buffers. Must be called on the thread that owns the
+         OpenGL context, like all the other methods except `stage`.
+
+         @param bytesPerFrame  The most pixel data that can be uploaded per frame.
+                               This is also the size of each staging buffer.
+         @param bufferCount  How many staging buffers to use. With 3, one can be
+                             filled while the GPU copies out of the other two.
+         */
+        TextureUploader(size_t bytesPerFrame = 8 * 1024 * 1024, unsigned bufferCount = 3);
+
+        /**
+         Deletes the staging buffers. Uploads that were staged but not issued yet
+         are dropped.
+         */
+        ~TextureUploader();
+
+        /**
+         Copies pixels into the staging buffer, to be uploaded into `texture` on the
+         next call to `beginFrame`. Safe to call from any thread.
+
+         `texture` isn't ready until the upload is finished, and must not be deleted
+         before then.
+
+         @param texture  The texture to upload into. It must already have storage
+                         for the rectangle, e.g. from the size and format constructor.
+         @param pixels  The pixels to upload. Must be the same format as the
+                        texture. They are copied before this returns.
+         @param x  The column of the texture to start at
+         @param y  The row of the texture to start at
+         @param level  The mip level to upload into
+
+         @result false if there's no room left in the staging buffer this frame.
+                 Try again after the next `beginFrame`.
+
+         @throws std::exception if the pixels are bigger than `bytesPerFrame`, so
+                 they could never be staged, or are a different format to the texture
+         */
+        bool stage(Texture& texture, const BitmapView& pixels, GLint x = 0, GLint y = 0, GLint level = 0);
+
+        /**
+         Issues the uploads staged since the last call, then maps the next staging
+         buffer for `stage`. Call this once per frame.
+         */
+        void beginFrame();
+
+    private:
+        struct Buffer {
+            GLuint object;
+            GLsync fence;
+        };
+
+        struct StagedUpload {
+            Texture* texture;
+            size_t offset;
+            GLsizei width;
+            GLsizei height;
+            GLint x;
+            GLint y;
+            GLint level;
+        };
+
+        std::vector<Buffer> _buffers;
+        size_t _bufferSize;
+        unsigned _current;
+        unsigned char* _mapped;
+        size_t _used;
+        unsigned _copiesInProgress;
+        std::vector<StagedUpload> _staged;
+        std::mutex _mutex;
+        std::condition_variable _copiesDone;
+
+        void _issueStaged(std::vector<StagedUpload>& staged);
+        void _mapCurrent();
+
+        //copying disabled
+        TextureUploader(const TextureUploader&);
+        const TextureUploader& operator=(const TextureUploader&);
+    };
+
+}
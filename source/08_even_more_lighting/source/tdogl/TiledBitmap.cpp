@@ -0,0 +1,319 @@
+/*
+ tdogl::TiledBitmap
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TiledBitmap.h"
+#include "FileUtils.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+
+using namespace tdogl;
+
+static const char kMagic[4] = {'T', 'D', 'T', 'L'};
+static const unsigned kVersion = 2; //version 2 added the tile borders
+static const size_t kHeaderSize = 32;
+static const size_t kDataOffset = 4096; //so that the tiles start on a page boundary
+static const unsigned kMinTileSize = 16;
+static const unsigned kMaxTileSize = 4096;
+
+enum HeaderFlags {
+    HeaderFlag_SRGB = 1
+};
+
+
+/*
+ * Little endian helpers
+ */
+
+static void WriteU32(unsigned char* dest, unsigned value) {
+    for(unsigned i = 0; i < 4; ++i)
+        dest[i] = (unsigned char)(value >> (8*i));
+}
+
+static unsigned ReadU32(const unsigned char* src) {
+    unsigned value = 0;
+    for(unsigned i = 0; i < 4; ++i)
+        value |= (unsigned)src[i] << (8*i);
+    return value;
+}
+
+static bool SeekTo(FILE* file, unsigned long long offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool IsValidTileSize(unsigned tileSize) {
+    return tileSize >= kMinTileSize && tileSize <= kMaxTileSize && (tileSize & (tileSize - 1)) == 0;
+}
+
+//tiles are stored with a one pixel border on every side
+static unsigned PaddedTileSize(unsigned tileSize) {
+    return tileSize + 2;
+}
+
+/*
+ Fills `tile` with the pixels of `rows`, starting one pixel above and to the left
+ of `col` and `row`, so the tile gets a border from the pixels around it. Pixels
+ outside of `rows` are clamped to its nearest edge, which repeats the edge pixels
+ of the image and pads out the tiles on the right and bottom edges.
+ */
+static void FillTile(const BitmapView& tile, const BitmapView& rows, unsigned col, unsigned row) {
+    size_t pixelSize = tile.format();
+    int lastCol = (int)rows.width() - 1;
+    int lastRow = (int)rows.height() - 1;
+    //the columns of the tile that don't need clamping
+    int left = std::max(0, 1 - (int)col);
+    int right = std::min((int)tile.width(), lastCol - (int)col + 2);
+
+    for(unsigned y = 0; y < tile.height(); ++y){
+        int srcRow = std::min(std::max((int)(row + y) - 1, 0), lastRow);
+        const unsigned char* src = rows.rowPointer((unsigned)srcRow);
+        unsigned char* dest = tile.rowPointer(y);
+        memcpy(dest + left * pixelSize, src + (col + left - 1) * pixelSize, (right - left) * pixelSize);
+        for(int x = 0; x < left; ++x)
+            memcpy(dest + x * pixelSize, src, pixelSize);
+        for(int x = right; x < (int)tile.width(); ++x)
+            memcpy(dest + x * pixelSize, src + lastCol * pixelSize, pixelSize);
+    }
+}
+
+
+/*
+ * TiledBitmap class
+ */
+
+TiledBitmap::TiledBitmap(const std::string& filePath) :
+    _file(filePath)
+{
+    const unsigned char* bytes = _file.bytes();
+    if(_file.size() < kDataOffset || memcmp(bytes, kMagic, 4) != 0)
+        throw std::runtime_error(std::string("Not a tiled bitmap file: ") + filePath);
+    if(ReadU32(bytes + 4) != kVersion)
+        throw std::runtime_error(std::string("Unsupported tiled bitmap version: ") + filePath);
+
+    _srgb = (ReadU32(bytes + 8) & HeaderFlag_SRGB) != 0;
+    unsigned format = ReadU32(bytes + 12);
+    unsigned width = ReadU32(bytes + 16);
+    unsigned height = ReadU32(bytes + 20);
+    _tileSize = ReadU32(bytes + 24);
+    unsigned levelCount = ReadU32(bytes + 28);
+    if(format < 1 || format > 4 || width == 0 || height == 0 || !IsValidTileSize(_tileSize))
+        throw std::runtime_error(std::string("Tiled bitmap has an invalid header: ") + filePath);
+    _format = (Bitmap::Format)format;
+
+    _levels = _layout(width, height, _tileSize, _format);
+    const Level& last = _levels.back();
+    unsigned padded = PaddedTileSize(_tileSize);
+    unsigned long long end = last.offset + (unsigned long long)last.tilesAcross * last.tilesDown * padded * padded * _format;
+    if(levelCount != _levels.size() || end > _file.size())
+        throw std::runtime_error(std::string("Tiled bitmap is truncated or corrupt: ") + filePath);
+}
+
+void TiledBitmap::create(const std::string& filePath,
+                         unsigned width,
+                         unsigned height,
+                         Bitmap::Format format,
+                         const RowReader& readRows,
+                         unsigned tileSize,
+                         bool srgb)
+{
+    if(width == 0 || height == 0)
+        throw std::runtime_error("Tiled bitmaps can't be empty");
+    if(!IsValidTileSize(tileSize))
+        throw std::runtime_error("Tile size must be a power of two between 16 and 4096");
+
+    std::vector<Level> levels = _layout(width, height, tileSize, format);
+    FILE* file = CreateTempFile(filePath);
+    if(!file)
+        throw std::runtime_error(std::string("Failed to create tiled bitmap: ") + filePath);
+
+    unsigned char header[kDataOffset] = {};
+    memcpy(header, kMagic, 4);
+    WriteU32(header + 4, kVersion);
+    WriteU32(header + 8, srgb ? HeaderFlag_SRGB : 0);
+    WriteU32(header + 12, format);
+    WriteU32(header + 16, width);
+    WriteU32(header + 20, height);
+    WriteU32(header + 24, tileSize);
+    WriteU32(header + 28, (unsigned)levels.size());
+    bool ok = (fwrite(header, 1, kDataOffset, file) == kDataOffset);
+
+    //each level fills a strip one tile high, which is written out as a row of tiles
+    //when it's full. The strip is then shrunk into the strip of the next level down.
+    //Row 0 of a strip holds the last row of the strip above, and the strip isn't
+    //written until the first row of the strip below has been read in after it, so
+    //the tiles can have borders on every side.
+    std::vector<Bitmap> strips;
+    std::vector<unsigned> stripRows(levels.size(), 0);
+    std::vector<unsigned> rowsDone(levels.size(), 0);
+    for(size_t i = 0; i < levels.size(); ++i)
+        strips.push_back(Bitmap(levels[i].width, tileSize + 2, format));
+    unsigned padded = PaddedTileSize(tileSize);
+    Bitmap tile(padded, padded, format);
+    size_t tileBytes = (size_t)padded * padded * format;
+
+    std::function<void(unsigned, const BitmapView&)> addRows;
+    std::function<void(unsigned)> flushStrip = [&](unsigned level){
+        //write the strip as a row of tiles, which are contiguous in the file
+        const Level& info = levels[level];
+        unsigned tileY = (rowsDone[level] - stripRows[level]) / tileSize;
+        //the first strip has no row above it
+        unsigned firstRow = (tileY == 0) ? 1 : 0;
+        BitmapView available = strips[level].view(0, firstRow, info.width, stripRows[level] + 1 - firstRow);
+        ok = ok && SeekTo(file, info.offset + (unsigned long long)tileY * info.tilesAcross * tileBytes);
+        for(unsigned tileX = 0; tileX < info.tilesAcross && ok; ++tileX){
+            FillTile(tile, available, tileX * tileSize, 1 - firstRow);
+            ok = (fwrite(tile.pixelBuffer(), 1, tileBytes, file) == tileBytes);
+        }
+
+        if(ok && level + 1 < levels.size()){
+            //full strips have an even number of rows, so the box filter never
+            //reaches across strips, and the next level has no seams
+            BitmapView filled = strips[level].view(0, 1, info.width, std::min(stripRows[level], tileSize));
+            addRows(level + 1, Bitmap(filled).mipmap(Bitmap::Filter_Box, srgb));
+        }
+
+        //the last row becomes the row above the next strip, followed by the row read ahead
+        if(stripRows[level] > tileSize){
+            strips[level].view(0, 0, info.width, 2).copyFrom(strips[level].view(0, tileSize, info.width, 2));
+            stripRows[level] = 1;
+            //the row read ahead can be the last row of the level, which makes a strip of its own
+            if(rowsDone[level] == info.height)
+                flushStrip(level);
+        } else {
+            stripRows[level] = 0;
+        }
+    };
+    addRows = [&](unsigned level, const BitmapView& rows){
+        const Level& info = levels[level];
+        //the last strip of a level can shrink to one row too many, so clip it
+        unsigned count = std::min(rows.height(), info.height - rowsDone[level]);
+        for(unsigned row = 0; row < count && ok; ){
+            unsigned chunk = std::min(count - row, tileSize + 1 - stripRows[level]);
+            strips[level].view(0, 1 + stripRows[level], info.width, chunk).copyFrom(rows.subview(0, row, info.width, chunk));
+            row += chunk;
+            stripRows[level] += chunk;
+            rowsDone[level] += chunk;
+            if(stripRows[level] > tileSize || rowsDone[level] == info.height)
+                flushStrip(level);
+        }
+    };
+
+    try {
+        //level 0 is read straight into its strip, up to and including the row read ahead
+        while(rowsDone[0] < height && ok){
+            unsigned count = std::min(tileSize + 1 - stripRows[0], height - rowsDone[0]);
+            readRows(rowsDone[0], strips[0].view(0, 1 + stripRows[0], width, count));
+            stripRows[0] += count;
+            rowsDone[0] += count;
+            flushStrip(0);
+        }
+    } catch(...) {
+        FinishTempFile(file, filePath, false);
+        throw;
+    }
+
+    if(!FinishTempFile(file, filePath, ok))
+        throw std::runtime_error(std::string("Failed to write tiled bitmap: ") + filePath);
+}
+
+void TiledBitmap::create(const std::string& filePath, const BitmapView& image, unsigned tileSize, bool srgb) {
+    create(filePath, image.width(), image.height(), image.format(),
+           [&image](unsigned firstRow, const BitmapView& rows){
+               rows.copyFrom(image.subview(0, firstRow, image.width(), rows.height()));
+           },
+           tileSize, srgb);
+}
+
+Bitmap::Format TiledBitmap::format() const {
+    return _format;
+}
+
+bool TiledBitmap::isSRGB() const {
+    return _srgb;
+}
+
+unsigned TiledBitmap::tileSize() const {
+    return _tileSize;
+}
+
+unsigned TiledBitmap::levelCount() const {
+    return (unsigned)_levels.size();
+}
+
+unsigned TiledBitmap::levelWidth(unsigned level) const {
+    return _levels.at(level).width;
+}
+
+unsigned TiledBitmap::levelHeight(unsigned level) const {
+    return _levels.at(level).height;
+}
+
+unsigned TiledBitmap::tilesAcross(unsigned level) const {
+    return _levels.at(level).tilesAcross;
+}
+
+unsigned TiledBitmap::tilesDown(unsigned level) const {
+    return _levels.at(level).tilesDown;
+}
+
+BitmapView TiledBitmap::tile(unsigned level, unsigned tileX, unsigned tileY) const {
+    //the mapping is read only, but BitmapView has no const version
+    unsigned char* pixels = const_cast<unsigned char*>(_file.bytes()) + _tileOffset(level, tileX, tileY);
+    unsigned padded = PaddedTileSize(_tileSize);
+    return BitmapView(pixels, padded, padded, _format);
+}
+
+void TiledBitmap::prefetchTile(unsigned level, unsigned tileX, unsigned tileY) const {
+    unsigned padded = PaddedTileSize(_tileSize);
+    _file.willNeed(_tileOffset(level, tileX, tileY), (size_t)padded * padded * _format);
+}
+
+std::vector<TiledBitmap::Level> TiledBitmap::_layout(unsigned width, unsigned height, unsigned tileSize, Bitmap::Format format) {
+    std::vector<Level> levels;
+    unsigned long long offset = kDataOffset;
+    for(;;){
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.tilesAcross = (width + tileSize - 1) / tileSize;
+        level.tilesDown = (height + tileSize - 1) / tileSize;
+        level.offset = offset;
+        levels.push_back(level);
+        if(width <= tileSize && height <= tileSize)
+            return levels;
+
+        unsigned padded = PaddedTileSize(tileSize);
+        offset += (unsigned long long)level.tilesAcross * level.tilesDown * padded * padded * format;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+}
+
+size_t TiledBitmap::_tileOffset(unsigned level, unsigned tileX, unsigned tileY) const {
+    const Level& info = _levels.at(level);
+    if(tileX >= info.tilesAcross || tileY >= info.tilesDown)
+        throw std::runtime_error("Tile is outside of the tiled bitmap");
+    unsigned padded = PaddedTileSize(_tileSize);
+    size_t tileBytes = (size_t)padded * padded * _format;
+    return (size_t)info.offset + ((size_t)tileY * info.tilesAcross + tileX) * tileBytes;
+}
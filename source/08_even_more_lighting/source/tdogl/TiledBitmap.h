@@ -0,0 +1,158 @@
+/*
+ tdogl::TiledBitmap
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Bitmap.h"
+#include "MappedFile.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     A huge image stored on disk as square tiles, for images that are too big to
+     decode into memory or upload as one texture (satellite maps, scans, etc.)
+
+     The file is memory mapped, so only the tiles that are actually read get paged
+     in, and the OS can page them out again. The file holds a pyramid of levels,
+     each half the size of the one before it, down to a level that fits in a
+     single tile, so a zoomed out view only has to read a few small tiles.
+
+     Every tile in the file covers `tileSize` x `tileSize` pixels of the image, and
+     is stored with a one pixel border copied from the tiles around it, making it
+     `tileSize + 2` pixels wide and high. The border lets each tile be drawn on its
+     own with linear filtering, without seams where the tiles meet. At the edges of
+     the image, and past the right and bottom edges of the last tiles, the edge
+     pixels are repeated instead. Rows are stored top row first, like tdogl::Bitmap.
+
+     Use tdogl::TiledTexture to draw one.
+     */
+    class TiledBitmap {
+    public:
+        /**
+         Fills `rows` with the pixels of the image, starting at row `firstRow`.
+         `rows` is always the full width of the image.
+         */
+        typedef std::function<void(unsigned firstRow, const BitmapView& rows)> RowReader;
+
+        /**
+         Memory maps an existing tiled bitmap file.
+
+         @throws std::exception if the file can't be opened or isn't a valid tiled bitmap
+         */
+        explicit TiledBitmap(const std::string& filePath);
+
+        /**
+         Makes a tiled bitmap file from an image that is read in strips, so the
+         whole image never has to be in memory at once.
+
+         `readRows` is called from the top of the image down, about `tileSize` rows
+         at a time. Memory use is about two strips of the full image width. The smaller
+         levels are made with Bitmap::Filter_Box.
+
+         @param filePath  The file to write. It is written to a temporary file which
+                          is then renamed, like TextureFile::save.
+         @param tileSize  Width and height of the tiles. Must be a power of two
+                          between 16 and 4096.
+         @param srgb  Whether the color channels are sRGB encoded, see Bitmap::mipmaps
+
+         @throws std::exception if the file can't be written
+         */
+        static void create(const std::string& filePath,
+                           unsigned width,
+                           unsigned height,
+                           Bitmap::Format format,
+                           const RowReader& readRows,
+                           unsigned tileSize = 256,
+                           bool srgb = true);
+
+        /**
+         Makes a tiled bitmap file from an image that is already in memory.
+         */
+        static void create(const std::string& filePath,
+                           const BitmapView& image,
+                           unsigned tileSize = 256,
+                           bool srgb = true);
+
+        /** the format of every tile */
+        Bitmap::Format format() const;
+
+        /** whether the color channels are sRGB encoded */
+        bool isSRGB() const;
+
+        /** width and height of the part of the image each tile covers, in pixels */
+        unsigned tileSize() const;
+
+        /** the number of levels, including level 0. The last level is a single tile. */
+        unsigned levelCount() const;
+
+        /** width in pixels of the given level, not counting padding */
+        unsigned levelWidth(unsigned level) const;
+
+        /** height in pixels of the given level, not counting padding */
+        unsigned levelHeight(unsigned level) const;
+
+        /** number of tile columns in the given level */
+        unsigned tilesAcross(unsigned level) const;
+
+        /** number of tile rows in the given level */
+        unsigned tilesDown(unsigned level) const;
+
+        /**
+         A view of a tile, which points straight into the mapped file. Reading it
+         pages the tile in. The view is read only, writing through it will crash.
+         
+         The view includes the one pixel border, so it is `tileSize() + 2` pixels
+         wide and high, and pixel (1, 1) is the top left pixel of the tile.
+
+         @throws std::exception if the tile doesn't exist
+         */
+        BitmapView tile(unsigned level, unsigned tileX, unsigned tileY) const;
+
+        /**
+         Asks the OS to start paging the given tile in, without waiting for it.
+         Call this for tiles that will probably be needed soon.
+         */
+        void prefetchTile(unsigned level, unsigned tileX, unsigned tileY) const;
+
+    private:
+        struct Level {
+            unsigned width;
+            unsigned height;
+            unsigned tilesAcross;
+            unsigned tilesDown;
+            unsigned long long offset;
+        };
+
+        MappedFile _file;
+        Bitmap::Format _format;
+        bool _srgb;
+        unsigned _tileSize;
+        std::vector<Level> _levels;
+
+        static std::vector<Level> _layout(unsigned width, unsigned height, unsigned tileSize, Bitmap::Format format);
+        size_t _tileOffset(unsigned level, unsigned tileX, unsigned tileY) const;
+
+        //copying disabled
+        TiledBitmap(const TiledBitmap&);
+        const TiledBitmap& operator=(const TiledBitmap&);
+    };
+
+}
@@ -0,0 +1,194 @@
+/*
+ tdogl::TiledTexture
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "TiledTexture.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace tdogl;
+
+static unsigned long long TileKey(unsigned level, unsigned tileX, unsigned tileY) {
+    return ((unsigned long long)level << 56) | ((unsigned long long)tileY << 28) | tileX;
+}
+
+namespace {
+    struct WantedTile {
+        unsigned x;
+        unsigned y;
+        float distance;
+
+        bool operator<(const WantedTile& other) const {
+            return distance < other.distance;
+        }
+    };
+}
+
+TiledTexture::TiledTexture(const TiledBitmap& bitmap, unsigned maxResidentTiles) :
+    _bitmap(bitmap),
+    _maxResidentTiles(std::max(1u, maxResidentTiles)),
+    _frame(0)
+{
+}
+
+TiledTexture::~TiledTexture() {
+    std::map<unsigned long long, Resident>::iterator it;
+    for(it = _resident.begin(); it != _resident.end(); ++it)
+        delete it->second.texture;
+}
+
+const std::vector<TiledTexture::Tile>& TiledTexture::update(glm::vec2 visibleMin,
+                                                            glm::vec2 visibleMax,
+                                                            float pixelsPerScreenPixel,
+                                                            unsigned maxUploads)
+{
+    ++_frame;
+    _tiles.clear();
+    unsigned uploads = 0;
+
+    //the smallest level is a single tile that everything else can fall back to,
+    //so it is uploaded first and never evicted
+    unsigned topLevel = _bitmap.levelCount() - 1;
+    Resident* top = _find(topLevel, 0, 0);
+    if(!top && uploads < maxUploads){
+        top = _upload(topLevel, 0, 0);
+        ++uploads;
+    }
+    if(top)
+        top->lastUsed = _frame;
+
+    glm::vec2 imageSize((float)_bitmap.levelWidth(0), (float)_bitmap.levelHeight(0));
+    visibleMin = glm::clamp(visibleMin, glm::vec2(0.0f), imageSize);
+    visibleMax = glm::clamp(visibleMax, glm::vec2(0.0f), imageSize);
+    if(visibleMin.x >= visibleMax.x || visibleMin.y >= visibleMax.y)
+        return _tiles;
+
+    //pick the level with between one and two pixels per screen pixel
+    unsigned level = 0;
+    while(level < topLevel && pixelsPerScreenPixel >= 2.0f){
+        pixelsPerScreenPixel /= 2.0f;
+        ++level;
+    }
+
+    float tileSize = (float)_bitmap.tileSize();
+    glm::vec2 scale = _levelScale(level);
+    glm::vec2 first = glm::floor(visibleMin * scale / tileSize);
+    glm::vec2 last = glm::ceil(visibleMax * scale / tileSize) - 1.0f;
+    unsigned lastX = std::min(_bitmap.tilesAcross(level) - 1, (unsigned)std::max(0.0f, last.x));
+    unsigned lastY = std::min(_bitmap.tilesDown(level) - 1, (unsigned)std::max(0.0f, last.y));
+
+    //upload the tiles nearest the middle of the view first
+    glm::vec2 middle = (visibleMin + visibleMax) * 0.5f * scale / tileSize;
+    std::vector<WantedTile> wanted;
+    for(unsigned y = (unsigned)first.y; y <= lastY; ++y){
+        for(unsigned x = (unsigned)first.x; x <= lastX; ++x){
+            WantedTile tile = { x, y, glm::length(glm::vec2(x + 0.5f, y + 0.5f) - middle) };
+            wanted.push_back(tile);
+        }
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    for(size_t i = 0; i < wanted.size(); ++i){
+        unsigned x = wanted[i].x;
+        unsigned y = wanted[i].y;
+        glm::vec2 min = glm::vec2(x, y) * tileSize / scale;
+        glm::vec2 max = glm::min(glm::vec2(x + 1, y + 1) * tileSize / scale, imageSize);
+
+        Resident* resident = _find(level, x, y);
+        if(!resident && uploads < maxUploads){
+            resident = _upload(level, x, y);
+            ++uploads;
+        }
+        if(resident){
+            _addTile(*resident, level, x, y, min, max);
+            continue;
+        }
+
+        //draw it from the nearest smaller level until it gets uploaded
+        _bitmap.prefetchTile(level, x, y);
+        glm::vec2 center = (min + max) * 0.5f;
+        for(unsigned parent = level + 1; parent <= topLevel; ++parent){
+            glm::vec2 parentTile = glm::floor(center * _levelScale(parent) / tileSize);
+            unsigned parentX = std::min(_bitmap.tilesAcross(parent) - 1, (unsigned)parentTile.x);
+            unsigned parentY = std::min(_bitmap.tilesDown(parent) - 1, (unsigned)parentTile.y);
+            Resident* parentResident = _find(parent, parentX, parentY);
+            if(parentResident){
+                _addTile(*parentResident, parent, parentX, parentY, min, max);
+                break;
+            }
+        }
+    }
+
+    return _tiles;
+}
+
+unsigned TiledTexture::residentTileCount() const {
+    return (unsigned)_resident.size();
+}
+
+TiledTexture::Resident* TiledTexture::_find(unsigned level, unsigned tileX, unsigned tileY) {
+    std::map<unsigned long long, Resident>::iterator it = _resident.find(TileKey(level, tileX, tileY));
+    return (it == _resident.end()) ? NULL : &it->second;
+}
+
+TiledTexture::Resident* TiledTexture::_upload(unsigned level, unsigned tileX, unsigned tileY) {
+    BitmapView pixels = _bitmap.tile(level, tileX, tileY);
+
+    //reuse the texture of the least recently drawn tile, if the limit is reached.
+    //Tiles drawn this frame are never reused, so the limit can be exceeded when
+    //more tiles are visible than the limit allows.
+    Texture* texture = NULL;
+    if(_resident.size() >= _maxResidentTiles){
+        std::map<unsigned long long, Resident>::iterator oldest = _resident.end();
+        std::map<unsigned long long, Resident>::iterator it;
+        for(it = _resident.begin(); it != _resident.end(); ++it){
+            if(it->second.lastUsed < _frame && (oldest == _resident.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+        }
+        if(oldest != _resident.end()){
+            texture = oldest->second.texture;
+            _resident.erase(oldest);
+        }
+    }
+
+    if(texture)
+        texture->update(pixels, 0, 0);
+    else
+        texture = new Texture(pixels, GL_LINEAR, GL_CLAMP_TO_EDGE);
+
+    Resident resident = { texture, _frame };
+    return &(_resident[TileKey(level, tileX, tileY)] = resident);
+}
+
+void TiledTexture::_addTile(Resident& resident, unsigned level, unsigned tileX, unsigned tileY,
+                            glm::vec2 min, glm::vec2 max)
+{
+    resident.lastUsed = _frame;
+
+    float tileSize = (float)_bitmap.tileSize();
+    glm::vec2 scale = _levelScale(level);
+    //the tile starts one pixel into the texture, after the border
+    glm::vec2 origin = glm::vec2(tileX, tileY) * tileSize - 1.0f;
+    float textureSize = tileSize + 2.0f;
+    Tile tile = { resident.texture, min, max, (min * scale - origin) / textureSize, (max * scale - origin) / textureSize };
+    _tiles.push_back(tile);
+}
+
+glm::vec2 TiledTexture::_levelScale(unsigned level) const {
+    return glm::vec2((float)_bitmap.levelWidth(level) / _bitmap.levelWidth(0),
+                     (float)_bitmap.levelHeight(level) / _bitmap.levelHeight(0));
+}
@@ -0,0 +1,114 @@
+/*
+ tdogl::TiledTexture
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#pragma once
+
+#include "Texture.h"
+#include "TiledBitmap.h"
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+
+namespace tdogl {
+
+    /**
+     Draws a tdogl::TiledBitmap by keeping only the tiles that are on screen in
+     video memory.
+
+     Each frame, call `update` with the part of the image that is visible and how
+     zoomed in the view is. It picks the level with about one pixel per screen
+     pixel, uploads the visible tiles of that level that aren't resident yet, and
+     returns the list of tiles to draw. Tiles that haven't been uploaded yet are
+     drawn from a smaller level in the meantime, so there are never holes. Once
+     the resident tile limit is reached, the least recently drawn tiles are
+     reused for new ones, so video memory use depends on the screen size, not
+     the image size.
+
+     Every tile is its own GL_TEXTURE_2D with no mipmaps, because the levels of
+     the tiled bitmap are the mipmaps. The textures include the one pixel border
+     of the tiles, and the texture coordinates only cover the inside of it, so
+     linear filtering blends into the neighbouring tiles and there are no seams.
+     */
+    class TiledTexture {
+    public:
+        /** A rectangle to draw, and the texture to draw it with */
+        struct Tile {
+            const Texture* texture; /**< the tile texture, which is `tileSize + 2` pixels square including the border */
+            glm::vec2 min; /**< top left corner of the rectangle, in level 0 pixels */
+            glm::vec2 max; /**< bottom right corner of the rectangle, in level 0 pixels */
+            glm::vec2 uvMin; /**< texture coordinate at `min` */
+            glm::vec2 uvMax; /**< texture coordinate at `max` */
+        };
+
+        /**
+         @param bitmap  The tiled bitmap. Must stay alive as long as this object.
+         @param maxResidentTiles  How many tiles to keep in video memory. This should
+                                  be at least the number of tiles that can be visible
+                                  at once, or tiles will be uploaded every frame.
+         */
+        TiledTexture(const TiledBitmap& bitmap, unsigned maxResidentTiles = 256);
+
+        /** Deletes all the tile textures */
+        ~TiledTexture();
+
+        /**
+         Uploads the tiles needed to draw the visible part of the image.
+
+         @param visibleMin  Top left corner of the visible area, in level 0 pixels
+         @param visibleMax  Bottom right corner of the visible area, in level 0 pixels
+         @param pixelsPerScreenPixel  How many level 0 pixels one screen pixel covers.
+                                      1 or less uses level 0, 2 uses level 1, 4 uses
+                                      level 2, etc.
+         @param maxUploads  The most tiles to upload during this call. The rest are
+                            prefetched from disk and uploaded by later calls.
+
+         @result The rectangles to draw, which cover the visible area without
+                 overlapping. Valid until the next call.
+         */
+        const std::vector<Tile>& update(glm::vec2 visibleMin,
+                                        glm::vec2 visibleMax,
+                                        float pixelsPerScreenPixel,
+                                        unsigned maxUploads = 8);
+
+        /** the number of tiles currently in video memory */
+        unsigned residentTileCount() const;
+
+    private:
+        struct Resident {
+            Texture* texture;
+            unsigned long long lastUsed;
+        };
+
+        const TiledBitmap& _bitmap;
+        unsigned _maxResidentTiles;
+        unsigned long long _frame;
+        std::map<unsigned long long, Resident> _resident;
+        std::vector<Tile> _tiles;
+
+        Resident* _find(unsigned level, unsigned tileX, unsigned tileY);
+        Resident* _upload(unsigned level, unsigned tileX, unsigned tileY);
+        void _addTile(Resident& resident, unsigned level, unsigned tileX, unsigned tileY,
+                      glm::vec2 min, glm::vec2 max);
+        glm::vec2 _levelScale(unsigned level) const;
+
+        //copying disabled
+        TiledTexture(const TiledTexture&);
+        const TiledTexture& operator=(const TiledTexture&);
+    };
+
+}
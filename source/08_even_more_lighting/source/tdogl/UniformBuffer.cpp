@@ -0,0 +1,63 @@
+/*
+ tdogl::UniformBuffer
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "UniformBuffer.h"
+#include <stdexcept>
+
+using namespace tdogl;
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint bindingPoint) :
+    _object(0),
+    _size(size),
+    _bindingPoint(bindingPoint)
+{
+    glGenBuffers(1, &_object);
+    if(_object == 0)
+        throw std::runtime_error("glGenBuffers failed");
+
+    glBindBuffer(GL_UNIFORM_BUFFER, _object);
+    glBufferData(GL_UNIFORM_BUFFER, _size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _object);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &_object);
+}
+
+void UniformBuffer::update(const void* data, GLsizeiptr size) {
+    if(size > _size)
+        throw std::runtime_error("Data is bigger than the uniform buffer");
+
+    glBindBuffer(GL_UNIFORM_BUFFER, _object);
+    glBufferData(GL_UNIFORM_BUFFER, _size, NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint UniformBuffer::object() const {
+    return _object;
+}
+
+GLuint UniformBuffer::bindingPoint() const {
+    return _bindingPoint;
+}
+
+GLsizeiptr UniformBuffer::size() const {
+    return _size;
+}
@@ -0,0 +1,91 @@
+/*
+ tdogl::UniformBuffer
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+#pragma once
+
+#include <GL/glew.h>
+
+namespace tdogl {
+
+    /**
+     Represents an OpenGL uniform buffer object, which holds the values of a
+     uniform block.
+
+     The buffer is bound to a uniform buffer binding point for its whole life.
+     Every tdogl::Program whose block is bound to the same point (see
+     tdogl::Program::setUniformBlockBinding) reads its values from this buffer, so
+     values that are the same for every draw call, like the camera, only have to
+     be uploaded once per frame instead of once per program or per draw.
+
+     The data passed to `update` must match the std140 layout of the block in the
+     shaders, including padding, e.g. a vec3 followed by a float packs into 16 bytes,
+     but a vec3 followed by a vec3 needs 4 bytes of padding in between.
+     */
+    class UniformBuffer {
+    public:
+        /**
+         Creates the buffer and binds it to `bindingPoint` with glBindBufferBase.
+
+         @param size  The size of the uniform block in bytes
+         @param bindingPoint  The uniform buffer binding point to bind to
+         */
+        UniformBuffer(GLsizeiptr size, GLuint bindingPoint);
+
+        /**
+         Deletes the buffer object with glDeleteBuffers
+         */
+        ~UniformBuffer();
+
+        /**
+         Replaces the contents of the buffer.
+
+         The old contents are orphaned first, so if the GPU is still drawing with
+         them the driver gives the buffer new storage instead of waiting.
+
+         @param data  The new contents, in std140 layout
+         @param size  The size of `data` in bytes. Must not be bigger than the buffer.
+         */
+        void update(const void* data, GLsizeiptr size);
+
+        /** Same as the other `update`, for a struct that matches the block's layout */
+        template <typename T>
+        void update(const T& block) {
+            update(&block, sizeof(T));
+        }
+
+        /**
+         @result The buffer object, as created by glGenBuffers
+         */
+        GLuint object() const;
+
+        /** the binding point the buffer is bound to */
+        GLuint bindingPoint() const;
+
+        /** the size of the buffer in bytes */
+        GLsizeiptr size() const;
+
+    private:
+        GLuint _object;
+        GLsizeiptr _size;
+        GLuint _bindingPoint;
+
+        //copying disabled
+        UniformBuffer(const UniformBuffer&);
+        const UniformBuffer& operator=(const UniformBuffer&);
+    };
+
+}
@@ -0,0 +1,397 @@
+/*
+ bitmap_benchmark
+
+ Copyright 2012 Thomas Dalling - http://tomdalling.com/
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ Measures the speed of the CPU side of the image pipeline: decoding, flipping,
+ rotating, copying, converting, mipmapping and per-pixel processing of
+ tdogl::Bitmap objects.
+
+ Doesn't need an OpenGL context, so it runs on headless machines. Results are
+ printed as a table, and written as JSON so runs can be compared.
+
+ Usage: bitmap_benchmark [--json <path>] [--filter <text>] [--min-time <seconds>] [image files...]
+
+   --json      Where to write the JSON results. Defaults to bitmap_benchmark.json
+   --filter    Only run benchmarks with names containing this text
+   --min-time  How long to repeat each benchmark for. Defaults to 0.25 seconds
+   image files Extra JPEG/PNG files to benchmark decoding of
+ */
+
+// standard C++ libraries
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// tdogl classes
+#include "tdogl/Bitmap.h"
+#include "tdogl/Parallel.h"
+#include "tdogl/PixelView.h"
+
+// writes the PNG and JPEG test images
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// the result of one benchmark
+struct BenchmarkResult {
+    std::string name;
+    double pixels; // pixels processed per iteration
+    double bytes; // bytes of pixels produced per iteration
+    unsigned iterations;
+    double minSeconds;
+    double medianSeconds;
+};
+
+// globals
+std::vector<BenchmarkResult> gResults;
+std::string gFilter;
+double gMinTime = 0.25;
+
+static const char* FormatName(tdogl::Bitmap::Format format) {
+    switch(format){
+        case tdogl::Bitmap::Format_Grayscale: return "gray";
+        case tdogl::Bitmap::Format_GrayscaleAlpha: return "grayalpha";
+        case tdogl::Bitmap::Format_RGB: return "rgb";
+        case tdogl::Bitmap::Format_RGBA: return "rgba";
+        default: return "unknown";
+    }
+}
+
+// fills a bitmap with smooth gradients and a little noise, so it compresses like a photo
+static tdogl::Bitmap MakeTestBitmap(unsigned width, unsigned height, tdogl::Bitmap::Format format) {
+    tdogl::Bitmap bmp(width, height, format);
+    unsigned seed = 12345;
+    unsigned char* pixel = bmp.pixelBuffer();
+    for(unsigned row = 0; row < height; ++row){
+        for(unsigned col = 0; col < width; ++col){
+            for(unsigned c = 0; c < (unsigned)format; ++c){
+                seed = seed * 1664525u + 1013904223u;
+                float wave = std::sin(col * 0.02f + c) * std::cos(row * 0.015f - c);
+                int value = (int)(128 + 100 * wave) + (int)((seed >> 28) & 7) - 4;
+                *pixel++ = (unsigned char)std::min(255, std::max(0, value));
+            }
+        }
+    }
+    return bmp;
+}
+
+
+/*
+ Test images, so decoding can be benchmarked on images of any size.
+ */
+
+// writes `bmp` as a JPEG if `extension` is "jpg", otherwise as a PNG
+static void WriteTestImage(const std::string& filePath, const tdogl::Bitmap& bmp, const std::string& extension) {
+    int ok = (extension == "jpg")
+        ? stbi_write_jpg(filePath.c_str(), bmp.width(), bmp.height(), bmp.format(), bmp.pixelBuffer(), 90)
+        : stbi_write_png(filePath.c_str(), bmp.width(), bmp.height(), bmp.format(), bmp.pixelBuffer(), 0);
+    if(!ok)
+        throw std::runtime_error("Failed to write " + filePath);
+}
+
+
+/*
+ Benchmarking
+ */
+
+// calls `func` repeatedly for at least gMinTime seconds, and records how long each call took
+static void Benchmark(const std::string& name, double pixels, double bytes, const std::function<void()>& func) {
+    if(!gFilter.empty() && name.find(gFilter) == std::string::npos)
+        return;
+
+    typedef std::chrono::steady_clock Clock;
+    func(); // warm up
+
+    std::vector<double> times;
+    Clock::time_point start = Clock::now();
+    do {
+        Clock::time_point before = Clock::now();
+        func();
+        times.push_back(std::chrono::duration<double>(Clock::now() - before).count());
+    } while(std::chrono::duration<double>(Clock::now() - start).count() < gMinTime || times.size() < 3);
+
+    std::sort(times.begin(), times.end());
+    BenchmarkResult result;
+    result.name = name;
+    result.pixels = pixels;
+    result.bytes = bytes;
+    result.iterations = (unsigned)times.size();
+    result.minSeconds = times.front();
+    result.medianSeconds = times[times.size() / 2];
+    gResults.push_back(result);
+
+    printf("%-40s %8u iters %12.1f us %10.1f MB/s %10.1f Mpixels/s\n",
+           name.c_str(),
+           result.iterations,
+           result.medianSeconds * 1e6,
+           bytes / result.medianSeconds / 1e6,
+           pixels / result.medianSeconds / 1e6);
+    fflush(stdout);
+}
+
+static std::string FileName(const std::string& filePath) {
+    size_t slash = filePath.find_last_of("/\\");
+    return (slash == std::string::npos) ? filePath : filePath.substr(slash + 1);
+}
+
+static void BenchmarkDecode(const std::string& name, const std::string& filePath) {
+    tdogl::Bitmap bmp = tdogl::Bitmap::bitmapFromFile(filePath);
+    double pixels = (double)bmp.width() * bmp.height();
+    Benchmark("decode/" + name, pixels, pixels * bmp.format(), [&](){
+        tdogl::Bitmap::bitmapFromFile(filePath);
+    });
+}
+
+static void BenchmarkDecoding(const std::vector<std::string>& imagePaths, const std::string& tempDir) {
+    for(size_t i = 0; i < imagePaths.size(); ++i){
+        FILE* f = fopen(imagePaths[i].c_str(), "rb");
+        if(!f){
+            fprintf(stderr, "Skipping missing image: %s\n", imagePaths[i].c_str());
+            continue;
+        }
+        fclose(f);
+        BenchmarkDecode(FileName(imagePaths[i]), imagePaths[i]);
+    }
+
+    // JPEG has no alpha channel, so only RGB is written as JPEG
+    struct TestImage { const char* extension; tdogl::Bitmap::Format format; };
+    static const TestImage testImages[] = {
+        {"png", tdogl::Bitmap::Format_RGB},
+        {"png", tdogl::Bitmap::Format_RGBA},
+        {"jpg", tdogl::Bitmap::Format_RGB},
+    };
+    static const unsigned sizes[] = {256, 1024, 2048};
+    for(unsigned s = 0; s < 3; ++s){
+        for(unsigned t = 0; t < 3; ++t){
+            const TestImage& image = testImages[t];
+            char name[64];
+            sprintf(name, "%s_%s_%u", image.extension, FormatName(image.format), sizes[s]);
+            if(!gFilter.empty() && ("decode/" + std::string(name)).find(gFilter) == std::string::npos)
+                continue;
+
+            std::string filePath = tempDir + "/bitmap_benchmark_" + name + "." + image.extension;
+            WriteTestImage(filePath, MakeTestBitmap(sizes[s], sizes[s], image.format), image.extension);
+            BenchmarkDecode(name, filePath);
+            remove(filePath.c_str());
+        }
+    }
+}
+
+static void BenchmarkTransforms() {
+    static const unsigned sizes[] = {256, 2048};
+    for(unsigned s = 0; s < 2; ++s){
+        for(int f = tdogl::Bitmap::Format_Grayscale; f <= tdogl::Bitmap::Format_RGBA; ++f){
+            tdogl::Bitmap bmp = MakeTestBitmap(sizes[s], sizes[s], (tdogl::Bitmap::Format)f);
+            double pixels = (double)sizes[s] * sizes[s];
+            char suffix[64];
+            sprintf(suffix, "%s_%u", FormatName(bmp.format()), sizes[s]);
+
+            Benchmark(std::string("flip/") + suffix, pixels, pixels * f, [&](){
+                bmp.flipVertically();
+            });
+            Benchmark(std::string("rotate90/") + suffix, pixels, pixels * f, [&](){
+                bmp.rotate90CounterClockwise();
+            });
+        }
+    }
+}
+
+static void BenchmarkCopies() {
+    const unsigned size = 1024;
+    for(int srcFormat = tdogl::Bitmap::Format_Grayscale; srcFormat <= tdogl::Bitmap::Format_RGBA; ++srcFormat){
+        tdogl::Bitmap src = MakeTestBitmap(size, size, (tdogl::Bitmap::Format)srcFormat);
+        for(int destFormat = tdogl::Bitmap::Format_Grayscale; destFormat <= tdogl::Bitmap::Format_RGBA; ++destFormat){
+            tdogl::Bitmap dest(size, size, (tdogl::Bitmap::Format)destFormat);
+            std::string pair = std::string(FormatName(src.format())) + "_to_" + FormatName(dest.format());
+
+            // whole bitmaps, which have contiguous rows
+            double pixels = (double)size * size;
+            Benchmark("convert/" + pair, pixels, pixels * destFormat, [&](){
+                dest.copyRectFromBitmap(src, 0, 0, 0, 0, 0, 0);
+            });
+
+            // a rect in the middle, which copies row by row
+            unsigned rectSize = size - 64;
+            pixels = (double)rectSize * rectSize;
+            Benchmark("copyrect/" + pair, pixels, pixels * destFormat, [&](){
+                dest.copyRectFromBitmap(src, 32, 32, 16, 48, rectSize, rectSize);
+            });
+        }
+    }
+}
+
+static void BenchmarkMipmaps() {
+    tdogl::Bitmap bmp = MakeTestBitmap(1024, 1024, tdogl::Bitmap::Format_RGBA);
+    double pixels = 1024.0 * 1024.0;
+    Benchmark("mipmaps/box_srgb_rgba_1024", pixels, pixels * 4 / 3, [&](){
+        bmp.mipmaps(tdogl::Bitmap::Filter_Box, true);
+    });
+    Benchmark("mipmaps/kaiser_srgb_rgba_1024", pixels, pixels * 4 / 3, [&](){
+        bmp.mipmaps(tdogl::Bitmap::Filter_Kaiser, true);
+    });
+}
+
+static void BenchmarkResizing() {
+    static const tdogl::Bitmap::Filter filters[] = {
+        tdogl::Bitmap::Filter_Box, tdogl::Bitmap::Filter_Bilinear, tdogl::Bitmap::Filter_Lanczos
+    };
+    static const char* filterNames[] = {"box", "bilinear", "lanczos"};
+    for(int f = tdogl::Bitmap::Format_RGB; f <= tdogl::Bitmap::Format_RGBA; ++f){
+        tdogl::Bitmap bmp = MakeTestBitmap(2048, 2048, (tdogl::Bitmap::Format)f);
+        double pixels = 2048.0 * 2048.0;
+        for(unsigned i = 0; i < 3; ++i){
+            // an awkward ratio, like clamping an asset to a maximum size
+            std::string suffix = std::string(filterNames[i]) + "_" + FormatName(bmp.format()) + "_2048";
+            Benchmark("resize/down_" + suffix, pixels, pixels * f, [&](){
+                bmp.resized(700, 700, filters[i], true);
+            });
+        }
+    }
+}
+
+static void BenchmarkPixelAccess() {
+    const unsigned size = 1024;
+    tdogl::Bitmap rgba = MakeTestBitmap(size, size, tdogl::Bitmap::Format_RGBA);
+    tdogl::Bitmap rgb = MakeTestBitmap(size, size, tdogl::Bitmap::Format_RGB);
+    tdogl::Bitmap mask(size, size, tdogl::Bitmap::Format_Grayscale);
+    double pixels = (double)size * size;
+    
+    // premultiplying alpha, one getPixel/setPixel call per pixel
+    Benchmark("pixels/premultiply_getpixel_1024", pixels, pixels * 4, [&](){
+        for(unsigned row = 0; row < size; ++row){
+            for(unsigned col = 0; col < size; ++col){
+                unsigned char p[4];
+                memcpy(p, rgba.getPixel(col, row), 4);
+                for(int c = 0; c < 3; ++c)
+                    p[c] = (unsigned char)((p[c] * p[3] + 127) / 255);
+                rgba.setPixel(col, row, p);
+            }
+        }
+    });
+    
+    // the same, with the format dispatched once
+    Benchmark("pixels/premultiply_foreach_1024", pixels, pixels * 4, [&](){
+        tdogl::ForEachPixel<tdogl::Bitmap::Format_RGBA>(rgba, [](tdogl::RGBA8& p){
+            p.r = (unsigned char)((p.r * p.a + 127) / 255);
+            p.g = (unsigned char)((p.g * p.a + 127) / 255);
+            p.b = (unsigned char)((p.b * p.a + 127) / 255);
+        });
+    });
+    
+    Benchmark("pixels/luminance_transform_1024", pixels, pixels, [&](){
+        tdogl::TransformPixels<tdogl::Bitmap::Format_RGB, tdogl::Bitmap::Format_Grayscale>(rgb, mask, [](const tdogl::RGB8& p){
+            tdogl::Gray8 result = { (unsigned char)((p.r * 54 + p.g * 183 + p.b * 19) >> 8) };
+            return result;
+        });
+    });
+}
+
+static void WriteJson(const std::string& filePath) {
+    FILE* f = (filePath == "-") ? stdout : fopen(filePath.c_str(), "w");
+    if(!f)
+        throw std::runtime_error("Failed to write " + filePath);
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"tdogl_bitmap\",\n");
+#ifdef NDEBUG
+    fprintf(f, "  \"config\": \"release\",\n");
+#else
+    fprintf(f, "  \"config\": \"debug\",\n");
+#endif
+    fprintf(f, "  \"worker_threads\": %u,\n", tdogl::WorkerThreadCount());
+    fprintf(f, "  \"results\": [\n");
+    for(size_t i = 0; i < gResults.size(); ++i){
+        const BenchmarkResult& r = gResults[i];
+        fprintf(f, "    {\"name\": \"%s\", \"iterations\": %u, \"pixels\": %.0f, \"bytes\": %.0f, "
+                   "\"min_ns\": %.0f, \"median_ns\": %.0f, \"mb_per_s\": %.2f, \"pixels_per_s\": %.0f}%s\n",
+                r.name.c_str(),
+                r.iterations,
+                r.pixels,
+                r.bytes,
+                r.minSeconds * 1e9,
+                r.medianSeconds * 1e9,
+                r.bytes / r.medianSeconds / 1e6,
+                r.pixels / r.medianSeconds,
+                (i + 1 < gResults.size()) ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    if(f != stdout)
+        fclose(f);
+}
+
+// the directory that contains the executable, which is where the repo's resources are found relative to
+static std::string ExecutableDir(const char* argv0) {
+    std::string path(argv0);
+    size_t slash = path.find_last_of("/\\");
+    return (slash == std::string::npos) ? std::string(".") : path.substr(0, slash);
+}
+
+int main(int argc, char *argv[]) {
+    std::string jsonPath = "bitmap_benchmark.json";
+    std::string exeDir = ExecutableDir(argv[0]);
+    std::vector<std::string> imagePaths;
+    imagePaths.push_back(exeDir + "/../08_even_more_lighting/resources/wooden-crate.jpg");
+    imagePaths.push_back(exeDir + "/../02_textures/resources/hazard.png");
+
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--json" && i + 1 < argc){
+            jsonPath = argv[++i];
+        } else if(arg == "--filter" && i + 1 < argc){
+            gFilter = argv[++i];
+        } else if(arg == "--min-time" && i + 1 < argc){
+            gMinTime = atof(argv[++i]);
+        } else if(arg.compare(0, 2, "--") == 0){
+            fprintf(stderr, "usage: %s [--json <path>] [--filter <text>] [--min-time <seconds>] [image files...]\n", argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            imagePaths.push_back(arg);
+        }
+    }
+
+    const char* tempDir = getenv("TMPDIR");
+#if defined(_WIN32)
+    if(!tempDir) tempDir = getenv("TEMP");
+    if(!tempDir) tempDir = ".";
+#else
+    if(!tempDir) tempDir = "/tmp";
+#endif
+
+    try {
+        BenchmarkDecoding(imagePaths, tempDir);
+        BenchmarkTransforms();
+        BenchmarkCopies();
+        BenchmarkMipmaps();
+        BenchmarkResizing();
+        BenchmarkPixelAccess();
+        WriteJson(jsonPath);
+    } catch (const std::exception& e){
+        fprintf(stderr, "ERROR: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
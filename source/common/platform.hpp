@@ -9,3 +9,7 @@
 #include <string>
 
 std::string ResourcePath(std::string fileName);
+
+// returns the full path to `fileName` in a per-user cache directory that the app can
+// always write to, unlike the resources directory (e.g. inside a signed app bundle)
+std::string CachePath(std::string fileName);